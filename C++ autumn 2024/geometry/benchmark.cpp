@@ -0,0 +1,574 @@
+/*
+ * Geometry benchmark suite: make benchmark && ./benchmark [options]
+ *
+ *   --format=csv|json  output format, csv by default
+ *   --max-scale=N      largest workload, from 10^3 up to 10^7 (10^6 by default)
+ *   --filter=TEXT      run only the cases whose name contains TEXT
+ *   --seed=N           base seed of the generators, 2024 by default
+ *   --verify           check the segment sweep against the pairwise test on
+ *                      small random inputs and on every layout; the exit
+ *                      status is 1 if they disagree anywhere
+ *
+ * Workloads come from mt19937_64 seeded by the seed and the scale, so two
+ * runs with the same options time the same inputs, and the checksum column
+ * only changes when results do. Progress goes to stderr, results to stdout.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "calipers.h"
+#include "collision.h"
+#include "delaunay.h"
+#include "kd_tree.h"
+#include "segment_sweep.h"
+#include "shape_pool.h"
+
+namespace {
+
+struct Options {
+  bool json = false;
+  size_t max_scale = 1000000;
+  std::string filter{};
+  unsigned long long seed = 2024;
+  bool verify = false;
+};
+
+struct Result {
+  std::string name;
+  size_t scale;
+  double seconds;
+  double checksum;
+};
+
+class Suite {
+private:
+  Options options_;
+  std::vector<Result> results_;
+  bool failed_;
+
+public:
+  explicit Suite(const Options& options) : options_(options), results_(), failed_(false) {}
+
+  const Options& options() const {
+    return options_;
+  }
+
+  bool wants(const std::string& name) const {
+    return name.find(options_.filter) != std::string::npos;
+  }
+
+  std::mt19937_64 random(size_t scale, unsigned long long stream) const {
+    return std::mt19937_64(options_.seed ^ (scale * 0x9e3779b97f4a7c15ULL) ^ (stream << 56));
+  }
+
+  // work() returns a checksum of what it computed, which is reported and
+  // keeps the optimizer from dropping the timed code.
+  template <typename Work>
+  void run(const std::string& name, size_t scale, Work work) {
+    if (!wants(name)) {
+      return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    double checksum = work();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    results_.push_back({name, scale, seconds, checksum});
+    std::fprintf(stderr, "%-28s %9zu %11.6fs\n", name.c_str(), scale, seconds);
+  }
+
+  void fail() {
+    failed_ = true;
+  }
+
+  bool failed() const {
+    return failed_;
+  }
+
+  void print() const;
+};
+
+void Suite::print() const {
+  if (options_.json) {
+    std::printf("[\n");
+  } else {
+    std::printf("case,scale,seconds,ns_per_item,checksum\n");
+  }
+  for (size_t i = 0; i < results_.size(); ++i) {
+    const Result& result = results_[i];
+    double per_item = 1e9 * result.seconds / static_cast<double>(result.scale);
+    if (options_.json) {
+      std::printf("  {\"case\": \"%s\", \"scale\": %zu, \"seconds\": %.9f, \"ns_per_item\": %.3f, "
+                  "\"checksum\": %.17g}%s\n",
+                  result.name.c_str(), result.scale, result.seconds, per_item, result.checksum,
+                  i + 1 < results_.size() ? "," : "");
+    } else {
+      std::printf("%s,%zu,%.9f,%.3f,%.17g\n", result.name.c_str(), result.scale, result.seconds, per_item,
+                  result.checksum);
+    }
+  }
+  if (options_.json) {
+    std::printf("]\n");
+  }
+}
+
+// All workloads live in the square [0, 1000]^2.
+std::vector<Point> pointCloud(size_t n, std::mt19937_64& random) {
+  std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+  std::vector<Point> points;
+  points.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    double x = coordinate(random);
+    points.emplace_back(x, coordinate(random));
+  }
+  return points;
+}
+
+// Star-shaped simple polygon: sorted random angles at random radii.
+Polygon randomPolygon(size_t vertices, double max_radius, std::mt19937_64& random) {
+  std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+  std::uniform_real_distribution<double> angle(0.0, 2 * M_PI);
+  std::uniform_real_distribution<double> radius(max_radius / 10, max_radius);
+  double center_x = coordinate(random);
+  Point center(center_x, coordinate(random));
+  std::vector<double> angles(vertices);
+  for (double& value : angles) {
+    value = angle(random);
+  }
+  std::sort(angles.begin(), angles.end());
+  std::vector<Point> points;
+  points.reserve(vertices);
+  for (double value : angles) {
+    double length = radius(random);
+    points.emplace_back(center.x + length * std::cos(value), center.y + length * std::sin(value));
+  }
+  return Polygon(points);
+}
+
+constexpr size_t kPolygonVertices = 16;
+
+// Enough polygons for scale vertices in total.
+std::vector<Polygon> polygonSet(size_t scale, std::mt19937_64& random) {
+  std::vector<Polygon> polygons;
+  polygons.reserve(scale / kPolygonVertices);
+  for (size_t i = 0; i < scale / kPolygonVertices; ++i) {
+    polygons.push_back(randomPolygon(kPolygonVertices, 10.0, random));
+  }
+  return polygons;
+}
+
+std::vector<Ellipse> ellipseSet(size_t n, std::mt19937_64& random) {
+  std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+  std::uniform_real_distribution<double> offset(-5.0, 5.0);
+  std::uniform_real_distribution<double> slack(0.5, 5.0);
+  std::vector<Ellipse> ellipses;
+  ellipses.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    double x = coordinate(random);
+    Point focus1(x, coordinate(random));
+    double dx = offset(random);
+    Point focus2(focus1.x + dx, focus1.y + offset(random));
+    ellipses.emplace_back(focus1, focus2, std::hypot(focus2.x - focus1.x, focus2.y - focus1.y) + slack(random));
+  }
+  return ellipses;
+}
+
+// Short segments scattered over the square: few intersections.
+std::vector<Segment> randomSegments(size_t n, std::mt19937_64& random) {
+  std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+  std::uniform_real_distribution<double> offset(-5.0, 5.0);
+  std::vector<Segment> segments;
+  segments.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    Point begin(coordinate(random), coordinate(random));
+    segments.emplace_back(begin, Point(begin.x + offset(random), begin.y + offset(random)));
+  }
+  return segments;
+}
+
+// Horizontal and vertical lines: k = n^2 / 4 crossings.
+std::vector<Segment> gridSegments(size_t n) {
+  std::vector<Segment> segments;
+  double length = static_cast<double>(n);
+  for (size_t i = 0; i < n / 2; ++i) {
+    double position = static_cast<double>(2 * i) + 0.5;
+    segments.emplace_back(Point(0.0, position), Point(length, position));
+    segments.emplace_back(Point(position, 0.0), Point(position, length));
+  }
+  return segments;
+}
+
+// Every segment through the origin: one event shared by all of them.
+std::vector<Segment> starSegments(size_t n) {
+  std::vector<Segment> segments;
+  for (size_t i = 0; i < n; ++i) {
+    double angle = 3.14159265358979 * static_cast<double>(i) / static_cast<double>(n);
+    segments.emplace_back(Point(-std::cos(angle), -std::sin(angle)), Point(std::cos(angle), std::sin(angle)));
+  }
+  return segments;
+}
+
+// Overlapping pieces of one line.
+std::vector<Segment> collinearSegments(size_t n, std::mt19937_64& random) {
+  std::uniform_int_distribution<int> coordinate(0, 1000);
+  std::vector<Segment> segments;
+  for (size_t i = 0; i < n; ++i) {
+    double from = coordinate(random);
+    double to = coordinate(random);
+    segments.emplace_back(Point(from, 2 * from + 1), Point(to, 2 * to + 1));
+  }
+  return segments;
+}
+
+using SegmentPairs = std::vector<std::pair<size_t, size_t>>;
+
+SegmentPairs pairwiseIntersections(const std::vector<Segment>& segments) {
+  SegmentPairs pairs;
+  Point point;
+  for (size_t i = 0; i < segments.size(); ++i) {
+    for (size_t j = i + 1; j < segments.size(); ++j) {
+      if (detail::segmentsIntersect(segments[i], segments[j], point)) {
+        pairs.emplace_back(i, j);
+      }
+    }
+  }
+  return pairs;
+}
+
+// Collinear overlaps are reported at every event point they share, so the
+// same pair may come up more than once.
+SegmentPairs distinctPairs(const std::vector<SegmentIntersection>& intersections) {
+  SegmentPairs pairs;
+  for (const SegmentIntersection& intersection : intersections) {
+    for (size_t i = 0; i < intersection.segments.size(); ++i) {
+      for (size_t j = i + 1; j < intersection.segments.size(); ++j) {
+        pairs.emplace_back(intersection.segments[i], intersection.segments[j]);
+      }
+    }
+  }
+  std::sort(pairs.begin(), pairs.end());
+  pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+  return pairs;
+}
+
+bool sweepAgrees(const std::vector<Segment>& segments, const std::vector<SegmentIntersection>& intersections) {
+  SegmentPairs expected = pairwiseIntersections(segments);
+  return distinctPairs(intersections) == expected && hasIntersection(segments) == !expected.empty();
+}
+
+// Small inputs that are hard on the sweep: integer coordinates with shared
+// endpoints and collinear pieces, thirds and sevenths that are not doubles,
+// and segments through one point that is not a double either.
+void verifySegmentSweep(Suite& suite) {
+  const size_t trials = 1000;
+  std::mt19937_64 random = suite.random(0, 5);
+  std::uniform_int_distribution<size_t> count(2, 24);
+  std::uniform_int_distribution<int> integer(0, 6);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::uniform_real_distribution<double> angle(0.0, M_PI);
+  const char* layouts[] = {"integer", "fractional", "concurrent"};
+  for (int layout = 0; layout < 3; ++layout) {
+    size_t disagreements = 0;
+    for (size_t trial = 0; trial < trials; ++trial) {
+      size_t n = count(random);
+      Point center(unit(random), unit(random));
+      auto coordinate = [&]() {
+        double k = integer(random);
+        if (layout == 0) {
+          return k;
+        }
+        return random() % 2 == 0 ? k / 3 : k / 7;
+      };
+      std::vector<Segment> segments;
+      for (size_t i = 0; i < n; ++i) {
+        if (layout < 2) {
+          double x = coordinate();
+          double y = coordinate();
+          double end_x = coordinate();
+          segments.emplace_back(Point(x, y), Point(end_x, coordinate()));
+        } else {
+          double direction = angle(random);
+          double forward = 0.5 + unit(random);
+          double backward = 0.5 + unit(random);
+          segments.emplace_back(
+              Point(center.x + forward * std::cos(direction), center.y + forward * std::sin(direction)),
+              Point(center.x - backward * std::cos(direction), center.y - backward * std::sin(direction)));
+        }
+      }
+      if (!sweepAgrees(segments, findIntersections(segments))) {
+        ++disagreements;
+      }
+    }
+    std::fprintf(stderr, "verify segments.%s: %zu of %zu inputs disagree\n", layouts[layout], disagreements,
+                 trials);
+    if (disagreements > 0) {
+      suite.fail();
+    }
+  }
+}
+
+void polygonCases(Suite& suite, size_t scale) {
+  std::mt19937_64 random = suite.random(scale, 1);
+  std::vector<Polygon> polygons = polygonSet(scale, random);
+
+  // The first pass fills the metric cache, the second one reads it.
+  for (const char* name : {"polygon.area.cold", "polygon.area.cached"}) {
+    suite.run(name, scale, [&polygons]() {
+      double sum = 0.0;
+      for (const Polygon& polygon : polygons) {
+        sum += polygon.area();
+      }
+      return sum;
+    });
+  }
+  for (const char* name : {"polygon.perimeter.cold", "polygon.perimeter.cached"}) {
+    suite.run(name, scale, [&polygons]() {
+      double sum = 0.0;
+      for (const Polygon& polygon : polygons) {
+        sum += polygon.perimeter();
+      }
+      return sum;
+    });
+  }
+
+  Polygon big = randomPolygon(64, 400.0, random);
+  BoundingBox box = big.boundingBox();
+  std::uniform_real_distribution<double> x(box.min.x, box.max.x);
+  std::uniform_real_distribution<double> y(box.min.y, box.max.y);
+  std::vector<Point> queries;
+  queries.reserve(scale);
+  for (size_t i = 0; i < scale; ++i) {
+    double query_x = x(random);
+    queries.emplace_back(query_x, y(random));
+  }
+  suite.run("polygon.containsPoint", scale, [&big, &queries]() {
+    double inside = 0.0;
+    for (const Point& query : queries) {
+      inside += big.containsPoint(query) ? 1.0 : 0.0;
+    }
+    return inside;
+  });
+
+  // Every polygon against a moved copy of itself, which matches, and against
+  // its neighbour in the set, which does not.
+  std::vector<Polygon> copies = polygons;
+  for (Polygon& copy : copies) {
+    copy.rotate(Point(500.0, 500.0), 37.0);
+    copy.reflect(Point(500.0, 500.0));
+  }
+  suite.run("polygon.isSimilarTo", scale, [&polygons, &copies]() {
+    double similar = 0.0;
+    for (size_t i = 0; i < polygons.size(); ++i) {
+      similar += polygons[i].isSimilarTo(copies[i]) ? 1.0 : 0.0;
+      similar += polygons[i].isSimilarTo(polygons[(i + 1) % polygons.size()]) ? 1.0 : 0.0;
+    }
+    return similar;
+  });
+  suite.run("polygon.isCongruentTo", scale, [&polygons, &copies]() {
+    double congruent = 0.0;
+    for (size_t i = 0; i < polygons.size(); ++i) {
+      congruent += polygons[i].isCongruentTo(copies[i]) ? 1.0 : 0.0;
+      congruent += polygons[i].isCongruentTo(polygons[(i + 1) % polygons.size()]) ? 1.0 : 0.0;
+    }
+    return congruent;
+  });
+
+  suite.run("polygon.transforms", scale, [&polygons]() {
+    Line axis(Point(0.0, 0.0), Point(1000.0, 700.0));
+    double sum = 0.0;
+    for (Polygon& polygon : polygons) {
+      polygon.rotate(Point(500.0, 500.0), 10.0);
+      polygon.reflect(axis);
+      polygon.scale(Point(500.0, 500.0), 1.5);
+      polygon.reflect(Point(500.0, 500.0));
+      sum += polygon.vertexSpan()[0].x;
+    }
+    return sum;
+  });
+
+  ShapePool pool;
+  pool.reserve(polygons.size(), scale, 0, 0);
+  for (const Polygon& polygon : polygons) {
+    pool.add(polygon);
+  }
+  suite.run("pool.totalArea", scale, [&pool]() { return pool.totalArea(); });
+  suite.run("pool.transforms", scale, [&pool]() {
+    pool.rotate(Point(500.0, 500.0), 10.0);
+    pool.reflect(Point(500.0, 500.0));
+    pool.scale(Point(500.0, 500.0), 1.5);
+    return pool.boundingBox().max.x;
+  });
+}
+
+void ellipseCases(Suite& suite, size_t scale) {
+  std::mt19937_64 random = suite.random(scale, 2);
+  std::vector<Ellipse> ellipses = ellipseSet(scale, random);
+  std::vector<Point> points = pointCloud(scale, random);
+
+  suite.run("ellipse.area", scale, [&ellipses]() {
+    double sum = 0.0;
+    for (const Ellipse& ellipse : ellipses) {
+      sum += ellipse.area();
+    }
+    return sum;
+  });
+  suite.run("ellipse.perimeter", scale, [&ellipses]() {
+    double sum = 0.0;
+    for (const Ellipse& ellipse : ellipses) {
+      sum += ellipse.perimeter();
+    }
+    return sum;
+  });
+
+  Ellipse big(Point(300.0, 400.0), Point(700.0, 600.0), 700.0);
+  suite.run("ellipse.containsPoint", scale, [&big, &points]() {
+    double inside = 0.0;
+    for (const Point& point : points) {
+      inside += big.containsPoint(point) ? 1.0 : 0.0;
+    }
+    return inside;
+  });
+  suite.run("ellipse.containsPoints", scale, [&big, &points]() {
+    return static_cast<double>(countContained(big, points));
+  });
+  suite.run("ellipse.isCongruentTo", scale, [&ellipses]() {
+    double congruent = 0.0;
+    for (size_t i = 0; i < ellipses.size(); ++i) {
+      congruent += ellipses[i].isCongruentTo(ellipses[i]) ? 1.0 : 0.0;
+      congruent += ellipses[i].isCongruentTo(ellipses[(i + 1) % ellipses.size()]) ? 1.0 : 0.0;
+    }
+    return congruent;
+  });
+  suite.run("ellipse.overlap", scale, [&ellipses]() {
+    double overlapping = 0.0;
+    for (size_t i = 0; i + 1 < ellipses.size(); ++i) {
+      overlapping += ellipsesOverlap(ellipses[i], ellipses[i + 1]) ? 1.0 : 0.0;
+    }
+    return overlapping;
+  });
+  suite.run("ellipse.transforms", scale, [&ellipses]() {
+    Line axis(Point(0.0, 0.0), Point(1000.0, 700.0));
+    double sum = 0.0;
+    for (Ellipse& ellipse : ellipses) {
+      ellipse.rotate(Point(500.0, 500.0), 10.0);
+      ellipse.reflect(axis);
+      ellipse.scale(Point(500.0, 500.0), 1.5);
+      sum += ellipse.area();
+    }
+    return sum;
+  });
+}
+
+void spatialCases(Suite& suite, size_t scale) {
+  std::mt19937_64 random = suite.random(scale, 3);
+  std::vector<Point> points = pointCloud(scale, random);
+  std::vector<Point> queries = pointCloud(scale, random);
+
+  std::unique_ptr<KdTree> tree;
+  suite.run("kdtree.build", scale, [&tree, &points]() {
+    tree = std::make_unique<KdTree>(points);
+    return static_cast<double>(tree->size());
+  });
+  if (tree) {
+    suite.run("kdtree.nearest", scale, [&tree, &queries]() {
+      double sum = 0.0;
+      for (const Point& query : queries) {
+        sum += static_cast<double>(tree->nearest(query));
+      }
+      return sum;
+    });
+  }
+  suite.run("closestPair", scale, [&points]() {
+    std::pair<size_t, size_t> pair = closestPair(points);
+    return static_cast<double>(std::min(pair.first, pair.second));
+  });
+  suite.run("convexHull+calipers", scale, [&points]() {
+    Polygon hull = convexHull(points);
+    PointSpan vertices = hull.vertexSpan();
+    return diameter(vertices) + width(vertices) + minAreaRectangle(vertices).area();
+  });
+  suite.run("minEnclosingCircle", scale, [&points]() { return minEnclosingCircle(points).radius(); });
+  suite.run("delaunay", scale, [&points]() {
+    Delaunay delaunay(points);
+    return static_cast<double>(delaunay.trianglesCount());
+  });
+}
+
+void segmentCases(Suite& suite, size_t scale) {
+  std::mt19937_64 random = suite.random(scale, 4);
+  auto sweep = [&suite, scale](const std::string& name, const std::vector<Segment>& segments) {
+    std::vector<SegmentIntersection> intersections;
+    suite.run("segments." + name, scale, [&intersections, &segments]() {
+      intersections = findIntersections(segments);
+      return static_cast<double>(distinctPairs(intersections).size());
+    });
+    suite.run("segments." + name + ".detect", scale, [&segments]() {
+      return hasIntersection(segments) ? 1.0 : 0.0;
+    });
+    if (suite.options().verify && segments.size() <= 10000 && suite.wants("segments." + name)
+        && !sweepAgrees(segments, intersections)) {
+      std::fprintf(stderr, "segments.%s: sweep and pairwise test disagree at scale %zu\n", name.c_str(), scale);
+      suite.fail();
+    }
+  };
+  sweep("random", randomSegments(scale, random));
+  // The other layouts have quadratic output or a quadratic-size event, so
+  // they stop growing early.
+  if (scale <= 100000) {
+    sweep("star", starSegments(scale / 10));
+  }
+  if (scale <= 1000) {
+    sweep("grid", gridSegments(scale));
+    sweep("collinear", collinearSegments(scale / 5, random));
+  }
+}
+
+Options parseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const char* argument = argv[i];
+    if (std::strcmp(argument, "--format=json") == 0) {
+      options.json = true;
+    } else if (std::strcmp(argument, "--format=csv") == 0) {
+      options.json = false;
+    } else if (std::strncmp(argument, "--max-scale=", 12) == 0) {
+      options.max_scale = std::strtoull(argument + 12, nullptr, 10);
+    } else if (std::strncmp(argument, "--filter=", 9) == 0) {
+      options.filter = argument + 9;
+    } else if (std::strncmp(argument, "--seed=", 7) == 0) {
+      options.seed = std::strtoull(argument + 7, nullptr, 10);
+    } else if (std::strcmp(argument, "--verify") == 0) {
+      options.verify = true;
+    } else {
+      std::fprintf(stderr, "unknown option %s\n", argument);
+      std::exit(1);
+    }
+  }
+  return options;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Suite suite(parseOptions(argc, argv));
+  size_t max_scale = std::min<size_t>(suite.options().max_scale, 10000000);
+  if (suite.options().verify) {
+    verifySegmentSweep(suite);
+  }
+  for (size_t scale = 1000; scale <= max_scale; scale *= 10) {
+    polygonCases(suite, scale);
+    ellipseCases(suite, scale);
+    spatialCases(suite, scale);
+    segmentCases(suite, scale);
+  }
+  suite.print();
+  return suite.failed() ? 1 : 0;
+}
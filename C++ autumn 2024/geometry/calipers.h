@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "geometry.h"
+
+/*
+ * Rotating calipers over a convex polygon given as a PointSpan of its
+ * vertices, in either orientation and without repeated or collinear
+ * consecutive vertices; convexHull() turns any point set into such a span.
+ * Each routine walks the boundary once, advancing antipodal pointers that
+ * never move backwards, so the whole pass is linear.
+ */
+
+namespace detail {
+
+// Twice the signed area of the triangle origin, a, b.
+inline double cross(const Point& origin, const Point& a, const Point& b) {
+  return (a.x - origin.x) * (b.y - origin.y) - (a.y - origin.y) * (b.x - origin.x);
+}
+
+inline double distanceSquared(const Point& a, const Point& b) {
+  return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y);
+}
+
+// Calls visit(i, j) for every edge i -> i + 1 of the hull and the vertex j
+// farthest from its line.
+template <typename Visit>
+void forEachAntipodal(PointSpan hull, Visit visit) {
+  size_t n = hull.size();
+  size_t j = 1;
+  for (size_t i = 0; i < n; ++i) {
+    const Point& from = hull[i];
+    const Point& to = hull[(i + 1) % n];
+    for (size_t steps = 0; steps < n; ++steps) {
+      size_t next = (j + 1) % n;
+      if (!(std::abs(cross(from, to, hull[next])) > std::abs(cross(from, to, hull[j])))) {
+        break;
+      }
+      j = next;
+    }
+    visit(i, j);
+  }
+}
+
+inline bool outsideCircle(const Point& point, const Point& center, double radius_squared) {
+  return distanceSquared(point, center) > radius_squared + kModule * std::max(1.0, radius_squared);
+}
+
+// The circle through three points, or around the farthest two of them when
+// they are collinear.
+inline std::pair<Point, double> circleThrough(const Point& a, const Point& b, const Point& c) {
+  double bx = b.x - a.x;
+  double by = b.y - a.y;
+  double cx = c.x - a.x;
+  double cy = c.y - a.y;
+  double d = 2.0 * (bx * cy - by * cx);
+  if (!nonZero(d)) {
+    std::pair<Point, Point> farthest(a, b);
+    if (distanceSquared(a, c) > distanceSquared(farthest.first, farthest.second)) {
+      farthest = {a, c};
+    }
+    if (distanceSquared(b, c) > distanceSquared(farthest.first, farthest.second)) {
+      farthest = {b, c};
+    }
+    Point center = (farthest.first + farthest.second) / 2.0;
+    return {center, distanceSquared(center, farthest.first)};
+  }
+  double b_lift = bx * bx + by * by;
+  double c_lift = cx * cx + cy * cy;
+  Point offset((cy * b_lift - by * c_lift) / d, (bx * c_lift - cx * b_lift) / d);
+  return {a + offset, offset.x * offset.x + offset.y * offset.y};
+}
+
+}  // namespace detail
+
+// Convex hull of any points by Andrew's monotone chain, counterclockwise and
+// without collinear vertices.
+Polygon convexHull(PointSpan points) {
+  std::vector<Point> sorted(points.begin(), points.end());
+  std::sort(sorted.begin(), sorted.end(), [](const Point& a, const Point& b) {
+    return a.x < b.x || (!(b.x < a.x) && a.y < b.y);
+  });
+  sorted.erase(std::unique(sorted.begin(), sorted.end(), [](const Point& a, const Point& b) {
+    return !(a.x < b.x || b.x < a.x || a.y < b.y || b.y < a.y);
+  }), sorted.end());
+  if (sorted.size() < 3) {
+    return Polygon(sorted);
+  }
+
+  std::vector<Point> hull(2 * sorted.size());
+  size_t size = 0;
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    while (size >= 2 && orientation(hull[size - 2], hull[size - 1], sorted[i]) <= 0) {
+      --size;
+    }
+    hull[size++] = sorted[i];
+  }
+  for (size_t i = sorted.size() - 1, lower = size + 1; i-- > 0;) {
+    while (size >= lower && orientation(hull[size - 2], hull[size - 1], sorted[i]) <= 0) {
+      --size;
+    }
+    hull[size++] = sorted[i];
+  }
+  hull.resize(size - 1);
+  return Polygon(hull);
+}
+
+// The two vertices of a convex polygon farthest apart.
+std::pair<Point, Point> farthestPair(PointSpan hull) {
+  if (hull.size() < 2) {
+    return hull.empty() ? std::pair<Point, Point>() : std::pair<Point, Point>(hull[0], hull[0]);
+  }
+  std::pair<Point, Point> best(hull[0], hull[1]);
+  double best_distance = detail::distanceSquared(hull[0], hull[1]);
+  detail::forEachAntipodal(hull, [&](size_t i, size_t j) {
+    for (size_t k : {i, (i + 1) % hull.size()}) {
+      double distance = detail::distanceSquared(hull[k], hull[j]);
+      if (distance > best_distance) {
+        best_distance = distance;
+        best = {hull[k], hull[j]};
+      }
+    }
+  });
+  return best;
+}
+
+double diameter(PointSpan hull) {
+  std::pair<Point, Point> farthest = farthestPair(hull);
+  return std::sqrt(detail::distanceSquared(farthest.first, farthest.second));
+}
+
+// Smallest distance between two parallel lines enclosing a convex polygon.
+double width(PointSpan hull) {
+  if (hull.size() < 3) {
+    return 0.0;
+  }
+  double best = std::numeric_limits<double>::infinity();
+  detail::forEachAntipodal(hull, [&](size_t i, size_t j) {
+    const Point& from = hull[i];
+    const Point& to = hull[(i + 1) % hull.size()];
+    best = std::min(best, std::abs(detail::cross(from, to, hull[j])) / std::sqrt(detail::distanceSquared(from, to)));
+  });
+  return best;
+}
+
+// Minimum-area rectangle enclosing a convex polygon; one of its sides lies on
+// an edge of the polygon.
+Polygon minAreaRectangle(PointSpan hull) {
+  size_t n = hull.size();
+  if (n < 2) {
+    Point corner = hull.empty() ? Point() : hull[0];
+    return Polygon(corner, corner, corner, corner);
+  }
+  auto projection = [&hull](size_t from, const Vector& direction, size_t k) {
+    return (hull[k].x - hull[from].x) * direction.x + (hull[k].y - hull[from].y) * direction.y;
+  };
+  auto height = [&hull](size_t from, const Vector& direction, size_t k) {
+    return direction.x * (hull[k].y - hull[from].y) - direction.y * (hull[k].x - hull[from].x);
+  };
+  // Walks k forwards while value(k) keeps growing.
+  auto advance = [n](size_t& k, auto value) {
+    for (size_t steps = 0; steps < n && value((k + 1) % n) > value(k); ++steps) {
+      k = (k + 1) % n;
+    }
+  };
+
+  double best_area = -1.0;
+  Polygon best(hull[0], hull[0], hull[0], hull[0]);
+  size_t right = 1;
+  size_t top = 1;
+  size_t left = 1;
+  for (size_t i = 0; i < n; ++i) {
+    Vector direction(hull[i], hull[(i + 1) % n]);
+    direction = direction / direction.length();
+    advance(right, [&](size_t k) { return projection(i, direction, k); });
+    if (i == 0) {
+      top = right;
+    }
+    advance(top, [&](size_t k) { return std::abs(height(i, direction, k)); });
+    if (i == 0) {
+      left = top;
+    }
+    advance(left, [&](size_t k) { return -projection(i, direction, k); });
+
+    double low = projection(i, direction, left);
+    double high = projection(i, direction, right);
+    double span = height(i, direction, top);
+    double area = (high - low) * std::abs(span);
+    if (best_area < 0 || area < best_area) {
+      best_area = area;
+      Vector normal(-direction.y * span, direction.x * span);
+      Point first = hull[i] + direction * low;
+      Point second = hull[i] + direction * high;
+      best = Polygon(first, second, second + normal, first + normal);
+    }
+  }
+  return best;
+}
+
+// Smallest circle containing all the points, by Welzl's algorithm in its
+// iterative move-to-front form: expected linear time after a shuffle.
+Circle minEnclosingCircle(PointSpan points) {
+  if (points.empty()) {
+    return Circle(Point(), 0.0);
+  }
+  std::vector<Point> shuffled(points.begin(), points.end());
+  std::mt19937_64 random(shuffled.size());
+  std::shuffle(shuffled.begin(), shuffled.end(), random);
+
+  Point center = shuffled[0];
+  double radius_squared = 0.0;
+  for (size_t i = 1; i < shuffled.size(); ++i) {
+    if (!detail::outsideCircle(shuffled[i], center, radius_squared)) {
+      continue;
+    }
+    center = shuffled[i];
+    radius_squared = 0.0;
+    for (size_t j = 0; j < i; ++j) {
+      if (!detail::outsideCircle(shuffled[j], center, radius_squared)) {
+        continue;
+      }
+      center = (shuffled[i] + shuffled[j]) / 2.0;
+      radius_squared = detail::distanceSquared(center, shuffled[i]);
+      for (size_t k = 0; k < j; ++k) {
+        if (detail::outsideCircle(shuffled[k], center, radius_squared)) {
+          std::pair<Point, double> circle = detail::circleThrough(shuffled[i], shuffled[j], shuffled[k]);
+          center = circle.first;
+          radius_squared = circle.second;
+        }
+      }
+    }
+  }
+  return Circle(center, std::sqrt(radius_squared));
+}
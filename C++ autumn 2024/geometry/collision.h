@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "geometry.h"
+
+/*
+ * Containment and overlap tests for collision detection. An ellipse is turned
+ * once into its implicit quadratic form
+ *
+ *   q(p) = xx * dx^2 + 2 * xy * dx * dy + yy * dy^2 <= 1,  (dx, dy) = p - center,
+ *
+ * so testing a point costs a handful of multiplications and no square roots,
+ * and batches of points go through SSE2 two at a time. Ellipses are assumed
+ * non-degenerate (positive minor semiaxis).
+ */
+
+struct QuadraticForm {
+  Point center;
+  double xx;
+  double xy;
+  double yy;
+
+  double value(const Point& point) const {
+    double dx = point.x - center.x;
+    double dy = point.y - center.y;
+    return xx * dx * dx + 2.0 * xy * dx * dy + yy * dy * dy;
+  }
+
+  bool contains(const Point& point) const {
+    return value(point) <= 1.0;
+  }
+};
+
+namespace detail {
+
+// Unit vector along the major axis; any direction for a circle.
+inline Vector majorAxis(const Ellipse& ellipse) {
+  Vector axis(ellipse.focus1, ellipse.focus2);
+  double length = axis.length();
+  return length > 0 ? axis / length : Vector(1.0, 0.0);
+}
+
+inline void containsKernel(const QuadraticForm& form, const Point* points, size_t count, char* inside) {
+  size_t i = 0;
+#ifdef __SSE2__
+  static_assert(sizeof(Point) == 2 * sizeof(double), "Point must be two packed doubles");
+  const __m128d center_x = _mm_set1_pd(form.center.x);
+  const __m128d center_y = _mm_set1_pd(form.center.y);
+  const __m128d xx = _mm_set1_pd(form.xx);
+  const __m128d xy = _mm_set1_pd(2.0 * form.xy);
+  const __m128d yy = _mm_set1_pd(form.yy);
+  const __m128d one = _mm_set1_pd(1.0);
+  for (; i + 2 <= count; i += 2) {
+    __m128d first = _mm_loadu_pd(&points[i].x);
+    __m128d second = _mm_loadu_pd(&points[i + 1].x);
+    __m128d dx = _mm_sub_pd(_mm_unpacklo_pd(first, second), center_x);
+    __m128d dy = _mm_sub_pd(_mm_unpackhi_pd(first, second), center_y);
+    __m128d q = _mm_mul_pd(_mm_mul_pd(xx, dx), dx);
+    q = _mm_add_pd(q, _mm_mul_pd(_mm_mul_pd(xy, dx), dy));
+    q = _mm_add_pd(q, _mm_mul_pd(_mm_mul_pd(yy, dy), dy));
+    int mask = _mm_movemask_pd(_mm_cmple_pd(q, one));
+    inside[i] = static_cast<char>(mask & 1);
+    inside[i + 1] = static_cast<char>((mask >> 1) & 1);
+  }
+#endif
+  for (; i < count; ++i) {
+    inside[i] = form.contains(points[i]) ? 1 : 0;
+  }
+}
+
+inline double pointSegmentDistanceSquared(const Point& point, const Point& begin, const Point& end) {
+  double ex = end.x - begin.x;
+  double ey = end.y - begin.y;
+  double px = point.x - begin.x;
+  double py = point.y - begin.y;
+  double length_squared = ex * ex + ey * ey;
+  double t = length_squared > 0 ? std::clamp((px * ex + py * ey) / length_squared, 0.0, 1.0) : 0.0;
+  double dx = px - t * ex;
+  double dy = py - t * ey;
+  return dx * dx + dy * dy;
+}
+
+inline bool sameValue(double a, double b) {
+  return !(a < b) && !(b < a);
+}
+
+// Distance from (y0, y1), y0, y1 >= 0, to the ellipse x0^2 / e0^2 + x1^2 / e1^2 = 1
+// with e0 >= e1 > 0, following Eberly's "Distance from a Point to an Ellipse":
+// the closest point solves a monotone equation in one variable, found by
+// bisection down to the last bit.
+inline double distanceToEllipse(double e0, double e1, double y0, double y1) {
+  if (y1 > 0) {
+    if (y0 > 0) {
+      double z0 = y0 / e0;
+      double z1 = y1 / e1;
+      double g = z0 * z0 + z1 * z1 - 1.0;
+      if (sameValue(g, 0.0)) {
+        return 0.0;
+      }
+      double r0 = (e0 / e1) * (e0 / e1);
+      double n0 = r0 * z0;
+      double s0 = z1 - 1.0;
+      double s1 = g < 0 ? 0.0 : std::hypot(n0, z1) - 1.0;
+      double s = 0.0;
+      for (int i = 0; i < 1100; ++i) {
+        s = (s0 + s1) / 2.0;
+        if (sameValue(s, s0) || sameValue(s, s1)) {
+          break;
+        }
+        double ratio0 = n0 / (s + r0);
+        double ratio1 = z1 / (s + 1.0);
+        g = ratio0 * ratio0 + ratio1 * ratio1 - 1.0;
+        if (g > 0) {
+          s0 = s;
+        } else if (g < 0) {
+          s1 = s;
+        } else {
+          break;
+        }
+      }
+      double x0 = r0 * y0 / (s + r0);
+      double x1 = y1 / (s + 1.0);
+      return std::hypot(x0 - y0, x1 - y1);
+    }
+    return std::abs(y1 - e1);
+  }
+  double numerator = e0 * y0;
+  double denominator = e0 * e0 - e1 * e1;
+  if (numerator < denominator) {
+    double ratio = numerator / denominator;
+    double x0 = e0 * ratio;
+    double x1 = e1 * std::sqrt(1.0 - ratio * ratio);
+    return std::hypot(x0 - y0, x1);
+  }
+  return std::abs(y0 - e0);
+}
+
+}  // namespace detail
+
+QuadraticForm quadraticForm(const Ellipse& ellipse) {
+  std::pair<double, double> semiaxis = ellipse.semiaxis();
+  Vector axis = detail::majorAxis(ellipse);
+  double major = 1.0 / (semiaxis.first * semiaxis.first);
+  double minor = 1.0 / (semiaxis.second * semiaxis.second);
+  return {ellipse.center(), axis.x * axis.x * major + axis.y * axis.y * minor,
+          axis.x * axis.y * (major - minor), axis.y * axis.y * major + axis.x * axis.x * minor};
+}
+
+// inside[i] is 1 when points[i] lies in the ellipse (boundary included).
+std::vector<char> containsPoints(const Ellipse& ellipse, PointSpan points) {
+  std::vector<char> inside(points.size());
+  detail::containsKernel(quadraticForm(ellipse), points.begin(), points.size(), inside.data());
+  return inside;
+}
+
+size_t countContained(const Ellipse& ellipse, PointSpan points) {
+  std::vector<char> inside = containsPoints(ellipse, points);
+  return static_cast<size_t>(std::count(inside.begin(), inside.end(), 1));
+}
+
+// Tight axis-aligned box of a rotated ellipse, for the broad phase.
+BoundingBox ellipseBoundingBox(const Ellipse& ellipse) {
+  std::pair<double, double> semiaxis = ellipse.semiaxis();
+  Vector axis = detail::majorAxis(ellipse);
+  double a = semiaxis.first;
+  double b = semiaxis.second;
+  double half_width = std::sqrt(a * a * axis.x * axis.x + b * b * axis.y * axis.y);
+  double half_height = std::sqrt(a * a * axis.y * axis.y + b * b * axis.x * axis.x);
+  Point center = ellipse.center();
+  return BoundingBox(Point(center.x - half_width, center.y - half_height),
+                     Point(center.x + half_width, center.y + half_height));
+}
+
+bool circlesOverlap(const Circle& first, const Circle& second) {
+  double reach = first.radius() + second.radius();
+  Point offset = first.center() - second.center();
+  return offset.x * offset.x + offset.y * offset.y <= reach * reach;
+}
+
+// Whether the disc and the polygon's area share a point: the center is inside
+// the polygon or some edge comes within the radius.
+bool circlePolygonOverlap(const Circle& circle, const Polygon& polygon) {
+  Point center = circle.center();
+  double radius = circle.radius();
+  BoundingBox box = polygon.boundingBox();
+  if (center.x + radius < box.min.x || box.max.x < center.x - radius
+      || center.y + radius < box.min.y || box.max.y < center.y - radius) {
+    return false;
+  }
+  PointSpan vertices = polygon.vertexSpan();
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    const Point& next = vertices[(i + 1) % vertices.size()];
+    if (detail::pointSegmentDistanceSquared(center, vertices[i], next) <= radius * radius) {
+      return true;
+    }
+  }
+  return polygon.containsPoint(center);
+}
+
+// Narrow phase for two ellipses. The affine map taking the first one to the
+// unit circle takes the second to another ellipse; they overlap iff the origin
+// is inside that ellipse or at most 1 away from it.
+bool ellipsesOverlap(const Ellipse& first, const Ellipse& second) {
+  std::pair<double, double> first_axes = first.semiaxis();
+  std::pair<double, double> second_axes = second.semiaxis();
+  Point offset = second.center() - first.center();
+  double center_distance = std::hypot(offset.x, offset.y);
+  if (center_distance > first_axes.first + second_axes.first) {
+    return false;
+  }
+  if (center_distance <= first_axes.second + second_axes.second) {
+    return true;
+  }
+
+  // Frame of the first ellipse, scaled to the unit circle: y = S R^T (x - c).
+  Vector u = detail::majorAxis(first);
+  double scale_major = 1.0 / first_axes.first;
+  double scale_minor = 1.0 / first_axes.second;
+  Point center((offset.x * u.x + offset.y * u.y) * scale_major, (offset.y * u.x - offset.x * u.y) * scale_minor);
+
+  // The second ellipse's form, M' = S^-1 R^T M R S^-1, in that frame.
+  QuadraticForm form = quadraticForm(second);
+  double rxx = form.xx * u.x * u.x + 2.0 * form.xy * u.x * u.y + form.yy * u.y * u.y;
+  double ryy = form.xx * u.y * u.y - 2.0 * form.xy * u.x * u.y + form.yy * u.x * u.x;
+  double rxy = (form.yy - form.xx) * u.x * u.y + form.xy * (u.x * u.x - u.y * u.y);
+  double mxx = rxx * first_axes.first * first_axes.first;
+  double myy = ryy * first_axes.second * first_axes.second;
+  double mxy = rxy * first_axes.first * first_axes.second;
+
+  QuadraticForm image{center, mxx, mxy, myy};
+  if (image.contains(Point())) {
+    return true;
+  }
+
+  // Eigenvectors of M' give the image's axes; eigenvalue lambda belongs to the
+  // semiaxis 1 / sqrt(lambda).
+  double mean = (mxx + myy) / 2.0;
+  double spread = std::hypot((mxx - myy) / 2.0, mxy);
+  double small = mean - spread;
+  double large = mean + spread;
+  Vector direction = std::abs(mxy) > 0 ? Vector(mxy, small - mxx) : (mxx <= myy ? Vector(1.0, 0.0) : Vector(0.0, 1.0));
+  direction = direction / direction.length();
+  double along = -(center.x * direction.x + center.y * direction.y);
+  double across = -(center.y * direction.x - center.x * direction.y);
+  double distance = detail::distanceToEllipse(1.0 / std::sqrt(small), 1.0 / std::sqrt(large),
+                                              std::abs(along), std::abs(across));
+  return distance <= 1.0;
+}
@@ -0,0 +1,490 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "geometry.h"
+#include "predicates.h"
+
+/*
+ * Delaunay triangulation by radial sweep-hull: points are inserted in order of
+ * distance from a seed circumcenter, each new point is connected to the visible
+ * part of the current convex hull and the new triangles are legalized by edge
+ * flips. Orientation and in-circle tests go through the adaptive predicates,
+ * so the result is exact for any input.
+ *
+ * The mesh is stored as half-edges: half-edge e belongs to triangle e / 3, runs
+ * from vertex triangles()[e] to triangles()[next(e)], and halfedges()[e] is its
+ * twin in the neighbouring triangle (kNone on the convex hull). All triangles
+ * are counterclockwise.
+ */
+class Delaunay {
+public:
+  static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+private:
+  std::vector<Point> points_;
+  std::vector<size_t> triangles_;
+  std::vector<size_t> halfedges_;
+  std::vector<size_t> hull_;
+
+  std::vector<size_t> hull_prev_;
+  std::vector<size_t> hull_next_;
+  std::vector<size_t> hull_tri_;
+  std::vector<size_t> hull_hash_;
+  std::vector<size_t> edge_stack_;
+  size_t hull_start_ = 0;
+  Point center_;
+
+  size_t hashKey(const Point& point) const;
+
+  // Mirror of the visibility test: true when p, q, r turn clockwise.
+  bool clockwise(size_t p, size_t q, size_t r) const {
+    return orient2d(points_[p].x, points_[p].y, points_[q].x, points_[q].y, points_[r].x, points_[r].y) < 0;
+  }
+
+  bool clockwise(const Point& p, size_t q, size_t r) const {
+    return orient2d(p.x, p.y, points_[q].x, points_[q].y, points_[r].x, points_[r].y) < 0;
+  }
+
+  void link(size_t a, size_t b) {
+    halfedges_[a] = b;
+    if (b != kNone) {
+      halfedges_[b] = a;
+    }
+  }
+
+  size_t addTriangle(size_t i0, size_t i1, size_t i2, size_t a, size_t b, size_t c);
+
+  size_t legalize(size_t a);
+
+  void build();
+
+public:
+  explicit Delaunay(const std::vector<Point>& points);
+
+  static size_t next(size_t edge) {
+    return edge % 3 == 2 ? edge - 2 : edge + 1;
+  }
+
+  static size_t prev(size_t edge) {
+    return edge % 3 == 0 ? edge + 2 : edge - 1;
+  }
+
+  const std::vector<Point>& points() const {
+    return points_;
+  }
+
+  const std::vector<size_t>& triangles() const {
+    return triangles_;
+  }
+
+  const std::vector<size_t>& halfedges() const {
+    return halfedges_;
+  }
+
+  // Convex hull vertices in counterclockwise order.
+  const std::vector<size_t>& hull() const {
+    return hull_;
+  }
+
+  size_t trianglesCount() const {
+    return triangles_.size() / 3;
+  }
+
+  Triangle triangle(size_t index) const {
+    return Triangle(points_[triangles_[3 * index]], points_[triangles_[3 * index + 1]],
+                    points_[triangles_[3 * index + 2]]);
+  }
+
+  std::vector<Triangle> toTriangles() const;
+
+  Point circumcenter(size_t triangle) const;
+
+  // Voronoi cell of every site whose star is closed; sites on the convex hull
+  // have unbounded cells and get an empty polygon.
+  std::vector<Polygon> voronoiCells() const;
+};
+
+namespace detail {
+
+inline double pseudoAngle(double dx, double dy) {
+  double p = dx / (std::abs(dx) + std::abs(dy));
+  return (dy > 0 ? 3 - p : 1 + p) / 4;
+}
+
+inline double circumradiusSquared(const Point& a, const Point& b, const Point& c) {
+  double dx = b.x - a.x;
+  double dy = b.y - a.y;
+  double ex = c.x - a.x;
+  double ey = c.y - a.y;
+  double bl = dx * dx + dy * dy;
+  double cl = ex * ex + ey * ey;
+  double d = 0.5 / (dx * ey - dy * ex);
+  double x = (ey * bl - dy * cl) * d;
+  double y = (dx * cl - ex * bl) * d;
+  return x * x + y * y;
+}
+
+inline Point circumcenter(const Point& a, const Point& b, const Point& c) {
+  double dx = b.x - a.x;
+  double dy = b.y - a.y;
+  double ex = c.x - a.x;
+  double ey = c.y - a.y;
+  double bl = dx * dx + dy * dy;
+  double cl = ex * ex + ey * ey;
+  double d = 0.5 / (dx * ey - dy * ex);
+  return Point(a.x + (ey * bl - dy * cl) * d, a.y + (dx * cl - ex * bl) * d);
+}
+
+inline double squaredDistance(const Point& a, const Point& b) {
+  return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y);
+}
+
+}  // namespace detail
+
+Delaunay::Delaunay(const std::vector<Point>& points)
+    : points_(points), triangles_(), halfedges_(), hull_(), hull_prev_(), hull_next_(),
+      hull_tri_(), hull_hash_(), edge_stack_(), center_() {
+  build();
+  hull_prev_ = std::vector<size_t>();
+  hull_next_ = std::vector<size_t>();
+  hull_tri_ = std::vector<size_t>();
+  hull_hash_ = std::vector<size_t>();
+  edge_stack_ = std::vector<size_t>();
+}
+
+size_t Delaunay::hashKey(const Point& point) const {
+  double angle = detail::pseudoAngle(point.x - center_.x, point.y - center_.y);
+  return static_cast<size_t>(std::floor(angle * static_cast<double>(hull_hash_.size()))) % hull_hash_.size();
+}
+
+size_t Delaunay::addTriangle(size_t i0, size_t i1, size_t i2, size_t a, size_t b, size_t c) {
+  size_t t = triangles_.size();
+  triangles_.push_back(i0);
+  triangles_.push_back(i1);
+  triangles_.push_back(i2);
+  halfedges_.resize(t + 3, kNone);
+  link(t, a);
+  link(t + 1, b);
+  link(t + 2, c);
+  return t;
+}
+
+/*
+ * Flip edge a while the quadrilateral around it is not locally Delaunay:
+ *
+ *           pl                    pl
+ *          /||\                  /  \
+ *       al/ || \bl            al/    \a
+ *        /  ||  \              /      \
+ *       /  a||b  \    flip    /___ar___\
+ *     p0\   ||   /p1   =>   p0\---bl---/p1
+ *        \  ||  /              \      /
+ *       ar\ || /br             b\    /br
+ *          \||/                  \  /
+ *           pr                    pr
+ */
+size_t Delaunay::legalize(size_t a) {
+  size_t ar = 0;
+  edge_stack_.clear();
+  while (true) {
+    size_t b = halfedges_[a];
+    size_t a0 = a - a % 3;
+    ar = a0 + (a + 2) % 3;
+
+    if (b == kNone) {
+      if (edge_stack_.empty()) {
+        break;
+      }
+      a = edge_stack_.back();
+      edge_stack_.pop_back();
+      continue;
+    }
+
+    size_t b0 = b - b % 3;
+    size_t al = a0 + (a + 1) % 3;
+    size_t bl = b0 + (b + 2) % 3;
+
+    const Point& p0 = points_[triangles_[ar]];
+    const Point& pr = points_[triangles_[a]];
+    const Point& pl = points_[triangles_[al]];
+    const Point& p1 = points_[triangles_[bl]];
+
+    if (incircle(p0.x, p0.y, pr.x, pr.y, pl.x, pl.y, p1.x, p1.y) > 0) {
+      triangles_[a] = triangles_[bl];
+      triangles_[b] = triangles_[ar];
+
+      size_t hbl = halfedges_[bl];
+      if (hbl == kNone) {
+        // The flipped edge was on the hull on the far side; fix the hull reference.
+        size_t e = hull_start_;
+        do {
+          if (hull_tri_[e] == bl) {
+            hull_tri_[e] = a;
+            break;
+          }
+          e = hull_prev_[e];
+        } while (e != hull_start_);
+      }
+      link(a, hbl);
+      link(b, halfedges_[ar]);
+      link(ar, bl);
+
+      edge_stack_.push_back(b0 + (b + 1) % 3);
+    } else {
+      if (edge_stack_.empty()) {
+        break;
+      }
+      a = edge_stack_.back();
+      edge_stack_.pop_back();
+    }
+  }
+  return ar;
+}
+
+void Delaunay::build() {
+  size_t n = points_.size();
+  if (n == 0) {
+    return;
+  }
+
+  BoundingBox box(points_[0], points_[0]);
+  for (const Point& point : points_) {
+    box.expand(point);
+  }
+  Point middle((box.min.x + box.max.x) / 2, (box.min.y + box.max.y) / 2);
+
+  // Seed triangle: the point closest to the middle, its nearest neighbour and
+  // the point forming the smallest circumcircle with both.
+  size_t i0 = 0;
+  double min_distance = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < n; ++i) {
+    double distance = detail::squaredDistance(middle, points_[i]);
+    if (distance < min_distance) {
+      i0 = i;
+      min_distance = distance;
+    }
+  }
+
+  size_t i1 = kNone;
+  min_distance = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < n; ++i) {
+    double distance = detail::squaredDistance(points_[i0], points_[i]);
+    if (i != i0 && distance < min_distance && distance > 0) {
+      i1 = i;
+      min_distance = distance;
+    }
+  }
+
+  size_t i2 = kNone;
+  double min_radius = std::numeric_limits<double>::infinity();
+  if (i1 != kNone) {
+    for (size_t i = 0; i < n; ++i) {
+      if (i == i0 || i == i1
+          || !detail::nonZero(orient2d(points_[i0].x, points_[i0].y, points_[i1].x, points_[i1].y,
+                                       points_[i].x, points_[i].y))) {
+        continue;
+      }
+      double radius = detail::circumradiusSquared(points_[i0], points_[i1], points_[i]);
+      if (radius < min_radius) {
+        i2 = i;
+        min_radius = radius;
+      }
+    }
+  }
+
+  std::vector<size_t> ids(n);
+  std::iota(ids.begin(), ids.end(), 0);
+
+  if (i2 == kNone) {
+    // Every point is collinear: no triangles, the hull is the sorted chain.
+    const Point& origin = points_[i0];
+    std::vector<double> projection(n);
+    double dx = i1 == kNone ? 1.0 : points_[i1].x - origin.x;
+    double dy = i1 == kNone ? 0.0 : points_[i1].y - origin.y;
+    for (size_t i = 0; i < n; ++i) {
+      projection[i] = (points_[i].x - origin.x) * dx + (points_[i].y - origin.y) * dy;
+    }
+    std::sort(ids.begin(), ids.end(), [&projection](size_t a, size_t b) { return projection[a] < projection[b]; });
+    double last = -std::numeric_limits<double>::infinity();
+    for (size_t id : ids) {
+      if (projection[id] > last) {
+        hull_.push_back(id);
+        last = projection[id];
+      }
+    }
+    return;
+  }
+
+  if (clockwise(i0, i1, i2)) {
+    std::swap(i1, i2);
+  }
+  center_ = detail::circumcenter(points_[i0], points_[i1], points_[i2]);
+
+  std::vector<double> distances(n);
+  for (size_t i = 0; i < n; ++i) {
+    distances[i] = detail::squaredDistance(points_[i], center_);
+  }
+  std::sort(ids.begin(), ids.end(), [&distances](size_t a, size_t b) { return distances[a] < distances[b]; });
+
+  size_t max_triangles = n < 3 ? 1 : 2 * n - 5;
+  triangles_.reserve(3 * max_triangles);
+  halfedges_.reserve(3 * max_triangles);
+
+  hull_prev_.assign(n, 0);
+  hull_next_.assign(n, 0);
+  hull_tri_.assign(n, 0);
+  hull_hash_.assign(static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(n)))), kNone);
+
+  hull_start_ = i0;
+  hull_next_[i0] = hull_prev_[i2] = i1;
+  hull_next_[i1] = hull_prev_[i0] = i2;
+  hull_next_[i2] = hull_prev_[i1] = i0;
+  hull_tri_[i0] = 0;
+  hull_tri_[i1] = 1;
+  hull_tri_[i2] = 2;
+  hull_hash_[hashKey(points_[i0])] = i0;
+  hull_hash_[hashKey(points_[i1])] = i1;
+  hull_hash_[hashKey(points_[i2])] = i2;
+
+  addTriangle(i0, i1, i2, kNone, kNone, kNone);
+
+  Point previous;
+  for (size_t k = 0; k < n; ++k) {
+    size_t i = ids[k];
+    const Point& point = points_[i];
+
+    // Exact duplicates are adjacent after sorting by distance.
+    if (k > 0 && !(point.x < previous.x || point.x > previous.x || point.y < previous.y || point.y > previous.y)) {
+      continue;
+    }
+    previous = point;
+    if (i == i0 || i == i1 || i == i2) {
+      continue;
+    }
+
+    // Find an edge of the hull visible from the point, starting from the
+    // hull vertex with the closest pseudo-angle.
+    size_t start = 0;
+    size_t key = hashKey(point);
+    for (size_t j = 0; j < hull_hash_.size(); ++j) {
+      start = hull_hash_[(key + j) % hull_hash_.size()];
+      if (start != kNone && start != hull_next_[start]) {
+        break;
+      }
+    }
+    start = hull_prev_[start];
+    size_t e = start;
+    size_t q = hull_next_[e];
+    while (!clockwise(point, e, q)) {
+      e = q;
+      if (e == start) {
+        e = kNone;
+        break;
+      }
+      q = hull_next_[e];
+    }
+    if (e == kNone) {
+      // Duplicate of a hull vertex.
+      continue;
+    }
+
+    size_t t = addTriangle(e, i, hull_next_[e], kNone, kNone, hull_tri_[e]);
+    hull_tri_[i] = legalize(t + 2);
+    hull_tri_[e] = t;
+
+    // Walk forward through the hull, adding triangles and flipping recursively.
+    size_t forward = hull_next_[e];
+    q = hull_next_[forward];
+    while (clockwise(point, forward, q)) {
+      t = addTriangle(forward, i, q, hull_tri_[i], kNone, hull_tri_[forward]);
+      hull_tri_[i] = legalize(t + 2);
+      hull_next_[forward] = forward;
+      forward = q;
+      q = hull_next_[forward];
+    }
+
+    // Walk backward from the other side.
+    if (e == start) {
+      q = hull_prev_[e];
+      while (clockwise(point, q, e)) {
+        t = addTriangle(q, i, e, kNone, hull_tri_[e], hull_tri_[q]);
+        legalize(t + 2);
+        hull_tri_[q] = t;
+        hull_next_[e] = e;
+        e = q;
+        q = hull_prev_[e];
+      }
+    }
+
+    hull_start_ = hull_prev_[i] = e;
+    hull_next_[e] = hull_prev_[forward] = i;
+    hull_next_[i] = forward;
+
+    hull_hash_[hashKey(point)] = i;
+    hull_hash_[hashKey(points_[e])] = e;
+  }
+
+  size_t e = hull_start_;
+  do {
+    hull_.push_back(e);
+    e = hull_next_[e];
+  } while (e != hull_start_);
+
+  triangles_.shrink_to_fit();
+  halfedges_.shrink_to_fit();
+}
+
+std::vector<Triangle> Delaunay::toTriangles() const {
+  std::vector<Triangle> result;
+  result.reserve(trianglesCount());
+  for (size_t i = 0; i < trianglesCount(); ++i) {
+    result.push_back(triangle(i));
+  }
+  return result;
+}
+
+Point Delaunay::circumcenter(size_t triangle) const {
+  return detail::circumcenter(points_[triangles_[3 * triangle]], points_[triangles_[3 * triangle + 1]],
+                              points_[triangles_[3 * triangle + 2]]);
+}
+
+std::vector<Polygon> Delaunay::voronoiCells() const {
+  // One incoming half-edge per site; hull sites keep the one whose twin is
+  // missing, so their walk below stops immediately at the open side.
+  std::vector<size_t> incoming(points_.size(), kNone);
+  for (size_t e = 0; e < triangles_.size(); ++e) {
+    size_t endpoint = triangles_[next(e)];
+    if (incoming[endpoint] == kNone || halfedges_[e] == kNone) {
+      incoming[endpoint] = e;
+    }
+  }
+
+  std::vector<Point> centers(trianglesCount());
+  for (size_t t = 0; t < centers.size(); ++t) {
+    centers[t] = circumcenter(t);
+  }
+
+  std::vector<Polygon> cells(points_.size(), Polygon(std::vector<Point>()));
+  for (size_t site = 0; site < points_.size(); ++site) {
+    size_t start = incoming[site];
+    if (start == kNone || halfedges_[start] == kNone) {
+      continue;
+    }
+    std::vector<Point> vertices;
+    size_t e = start;
+    do {
+      vertices.push_back(centers[e / 3]);
+      e = halfedges_[next(e)];
+    } while (e != start && e != kNone);
+    if (e == start) {
+      cells[site] = Polygon(vertices);
+    }
+  }
+  return cells;
+}
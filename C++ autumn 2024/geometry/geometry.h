@@ -5,6 +5,8 @@
 #include <iostream>
 #include <vector>
 
+#include "predicates.h"
+
 const double kModule = 1e-9;
 
 struct Vector;
@@ -42,8 +44,7 @@ struct Point {
   Point operator+(const Vector& vector) const;
 
   void rotate(const Point& center, double angle) {
-	*this -= center;
-    Point rotated = *this;
+    Point rotated(x - center.x, y - center.y);
     angle = (angle * M_PI) / 180.0;
 
     (*this).x = rotated.x * cos(angle) - rotated.y * sin(angle) + center.x;
@@ -85,6 +86,21 @@ void Point::scale(const Point& center, double coefficient) {
     *this = coefficient * (*this - center) + center;
 }
 
+// Sign of the turn a -> b -> c: 1 counterclockwise, -1 clockwise, 0 collinear.
+int orientation(const Point& a, const Point& b, const Point& c) {
+  if (predicate_policy == PredicatePolicy::kExact) {
+    double det = orient2d(a.x, a.y, b.x, b.y, c.x, c.y);
+    return (det > 0) - (det < 0);
+  }
+  double cross = (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+  if (cross > 0) {
+    return 1;
+  } else if (cross < 0) {
+    return -1;
+  }
+  return 0;
+}
+
 struct Vector {
     double x;
     double y;
@@ -126,6 +142,64 @@ Point Point::operator+(const Vector& vector) const {
   return Point(x + vector.x, y + vector.y);
 }
 
+struct BoundingBox {
+  Point min;
+  Point max;
+
+  BoundingBox() : min(), max() {}
+  BoundingBox(const Point& low, const Point& high) : min(low), max(high) {}
+
+  void expand(const Point& point) {
+    min.x = std::min(min.x, point.x);
+    min.y = std::min(min.y, point.y);
+    max.x = std::max(max.x, point.x);
+    max.y = std::max(max.y, point.y);
+  }
+
+  bool containsPoint(const Point& point) const {
+    return min.x <= point.x && point.x <= max.x && min.y <= point.y && point.y <= max.y;
+  }
+
+  bool intersects(const BoundingBox& other) const {
+    return min.x <= other.max.x && other.min.x <= max.x && min.y <= other.max.y && other.min.y <= max.y;
+  }
+};
+
+// Read-only view of contiguous points, such as the vertices of a Polygon,
+// for algorithms that only walk over them.
+class PointSpan {
+private:
+  const Point* data_;
+  size_t size_;
+
+public:
+  PointSpan() : data_(nullptr), size_(0) {}
+  PointSpan(const Point* data, size_t size) : data_(data), size_(size) {}
+  PointSpan(const std::vector<Point>& points) : data_(points.data()), size_(points.size()) {}
+  PointSpan(const PointSpan& span) = default;
+  PointSpan& operator=(const PointSpan& span) = default;
+
+  const Point& operator[](size_t index) const {
+    return data_[index];
+  }
+
+  const Point* begin() const {
+    return data_;
+  }
+
+  const Point* end() const {
+    return data_ + size_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+};
+
 class Line {
 private:
   double a;
@@ -173,6 +247,12 @@ public:
 };
 
 Point SLE(const Line& line1, const Line& line2) {
+    if (predicate_policy == PredicatePolicy::kExact) {
+      double d = det2(line1.getA(), line2.getA(), line1.getB(), line2.getB());
+      double dx = det2(line2.getC(), line1.getC(), line2.getB(), line1.getB());
+      double dy = det2(line2.getA(), line1.getA(), line2.getC(), line1.getC());
+      return Point(dx / d, dy / d);
+    }
 	double d = line1.getA() * line2.getB() - line2.getA() * line1.getB();
     double dx = -1 * line1.getC() * line2.getB() + line2.getC() * line1.getB();
     double dy = -1 * line1.getA() * line2.getC() + line2.getA() * line1.getC();
@@ -210,16 +290,39 @@ public:
 };
 
 class Polygon : public Shape {
+private:
+  // Derived quantities, computed on first use. Transforms update them in place
+  // where they can: rigid motions keep lengths, angles, area and convexity.
+  struct Metrics {
+    double area = 0.0;
+    double perimeter = 0.0;
+    std::vector<double> side_lengths{};
+    std::vector<double> angles{};
+    BoundingBox bounding_box{};
+    Point centroid{};
+    bool convex = false;
+
+    bool has_area = false;
+    bool has_perimeter = false;
+    bool has_side_lengths = false;
+    bool has_angles = false;
+    bool has_bounding_box = false;
+    bool has_centroid = false;
+    bool has_convexity = false;
+  };
+
+  mutable Metrics metrics;
+
 protected:
   std::vector<Point> vertices;
 
-  Polygon(int size) : vertices(size) {}
+  Polygon(int size) : metrics(), vertices(size) {}
 
 public:
-	Polygon(const std::vector<Point>& vertices) : vertices(vertices) {}
+	Polygon(const std::vector<Point>& vertices) : metrics(), vertices(vertices) {}
 
     template <typename... Args>
-	Polygon(Args... args) {
+	Polygon(Args... args) : metrics() {
   		vertices = {args...};
 	}
 
@@ -231,6 +334,10 @@ public:
         return vertices;
     }
 
+    PointSpan vertexSpan() const {
+        return PointSpan(vertices);
+    }
+
     int func(Vector vec1, Vector vec2) {
         if (vec1.x * vec2.y - vec1.y * vec2.x > 0) {
             return 1;
@@ -240,7 +347,85 @@ public:
         return 0;
     }
 
-    bool isConvex() {
+    bool isConvex() const {
+        if (!metrics.has_convexity) {
+            metrics.convex = computeConvexity();
+            metrics.has_convexity = true;
+        }
+        return metrics.convex;
+    }
+
+    double perimeter() const override {
+        if (!metrics.has_perimeter) {
+            double current_perimeter = 0.0;
+            for (double length : getSideLengths()) {
+                current_perimeter += length;
+            }
+            metrics.perimeter = current_perimeter;
+            metrics.has_perimeter = true;
+        }
+        return metrics.perimeter;
+    }
+
+    double area() const override {
+        if (!metrics.has_area) {
+		    double result = 0.0;
+    	    for (size_t i = 0; i < vertices.size(); ++i) {
+      		    const Point& p1 = vertices[i];
+     		    const Point& p2 = vertices[(i + 1) % vertices.size()];
+      		    result += (p1.x * p2.y - p2.x * p1.y);
+    	    }
+            metrics.area = 0.5 * fabs(result);
+            metrics.has_area = true;
+        }
+        return metrics.area;
+    }
+
+    BoundingBox boundingBox() const {
+        if (!metrics.has_bounding_box) {
+            BoundingBox box;
+            if (!vertices.empty()) {
+                box = BoundingBox(vertices[0], vertices[0]);
+            }
+            for (const Point& point : vertices) {
+                box.expand(point);
+            }
+            metrics.bounding_box = box;
+            metrics.has_bounding_box = true;
+        }
+        return metrics.bounding_box;
+    }
+
+    // Center of mass of the polygon's area; the vertex average when the area
+    // is zero.
+    Point centroid() const {
+        if (!metrics.has_centroid) {
+            double twice_area = 0.0;
+            double x = 0.0;
+            double y = 0.0;
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                const Point& p1 = vertices[i];
+                const Point& p2 = vertices[(i + 1) % vertices.size()];
+                double cross = p1.x * p2.y - p2.x * p1.y;
+                twice_area += cross;
+                x += (p1.x + p2.x) * cross;
+                y += (p1.y + p2.y) * cross;
+            }
+            if (std::abs(twice_area) < kModule) {
+                Point sum;
+                for (const Point& point : vertices) {
+                    sum = sum + point;
+                }
+                metrics.centroid = vertices.empty() ? sum : sum / static_cast<double>(vertices.size());
+            } else {
+                metrics.centroid = Point(x / (3.0 * twice_area), y / (3.0 * twice_area));
+            }
+            metrics.has_centroid = true;
+        }
+        return metrics.centroid;
+    }
+
+    bool computeConvexity() const {
         Point memory1;
         Point memory2;
         Point start1;
@@ -258,13 +443,13 @@ public:
                 start2 = point;
             }
             if (i == 2) {
-                flag = func(Vector(memory2, memory1), Vector(memory1, point));
+                flag = orientation(memory2, memory1, point);
             }
             if (i > 2) {
-                if (flag == 0 && func(Vector(memory2, memory1), Vector(memory1, point)) != 0) {
-                    flag = func(Vector(memory2, memory1), Vector(memory1, point));
-                } else if (func(Vector(memory2, memory1), Vector(memory1, point)) != 0
-                        && func(Vector(memory2, memory1), Vector(memory1, point)) != flag) {
+                if (flag == 0 && orientation(memory2, memory1, point) != 0) {
+                    flag = orientation(memory2, memory1, point);
+                } else if (orientation(memory2, memory1, point) != 0
+                        && orientation(memory2, memory1, point) != flag) {
                     return false;
                 }
             }
@@ -277,56 +462,47 @@ public:
             memory2 = memory1;
             memory1 = point;
         }
-        if (flag == 0 && func(Vector(end2, end1), Vector(end1, start1)) != 0) {
-            flag = func(Vector(end2, end1), Vector(end1, start1));
-        } else if (func(Vector(end2, end1), Vector(end1, start1)) != 0
-                && func(Vector(end2, end1), Vector(end1, start1)) != flag) {
+        if (flag == 0 && orientation(end2, end1, start1) != 0) {
+            flag = orientation(end2, end1, start1);
+        } else if (orientation(end2, end1, start1) != 0
+                && orientation(end2, end1, start1) != flag) {
             return false;
         }
-        if (flag == 0 && func(Vector(end1, start1), Vector(start1, start2)) != 0) {
-            flag = func(Vector(end1, start1), Vector(start1, start2));
-        } else if (func(Vector(end1, start1), Vector(start1, start2)) != 0
-                && func(Vector(end1, start1), Vector(start1, start2)) != flag) {
+        if (flag == 0 && orientation(end1, start1, start2) != 0) {
+            flag = orientation(end1, start1, start2);
+        } else if (orientation(end1, start1, start2) != 0
+                && orientation(end1, start1, start2) != flag) {
             return false;
         }
         return true;
     }
 
-    double perimeter() const override {
-        double current_perimeter = 0.0;
-        for (size_t i = 0; i < vertices.size(); ++i) {
-            size_t next_point = (i + 1) % vertices.size();
-            double dx = vertices[next_point].x - vertices[i].x;
-            double dy = vertices[next_point].y - vertices[i].y;
-            current_perimeter += std::sqrt(std::pow(dx, 2) + std::pow(dy, 2));
-        }
-        return current_perimeter;
-    }
-
-    double area() const override {
-		double result = 0.0;
-    	for (size_t i = 0; i < vertices.size(); ++i) {
-      		const Point& p1 = vertices[i];
-     		const Point& p2 = vertices[(i + 1) % vertices.size()];
-      		result += (p1.x * p2.y - p2.x * p1.y);
-    	}
-    	return 0.5 * fabs(result);
-    }
-
     double distance(const Point& p1, const Point& p2) const {
         return std::sqrt(std::pow(p2.x - p1.x, 2) + std::pow(p2.y - p1.y, 2));
     }
 
-    std::vector<double> getSideLengths() const {
-        std::vector<double> lengths;
-        for (size_t i = 0; i < vertices.size(); ++i) {
-            int next = (i + 1) % vertices.size();
-            lengths.push_back(distance(vertices[i], vertices[next]));
+    const std::vector<double>& getSideLengths() const {
+        if (!metrics.has_side_lengths) {
+            std::vector<double> lengths;
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                int next = (i + 1) % vertices.size();
+                lengths.push_back(distance(vertices[i], vertices[next]));
+            }
+            metrics.side_lengths = lengths;
+            metrics.has_side_lengths = true;
         }
-        return lengths;
+        return metrics.side_lengths;
     }
 
-    std::vector<double> getAngles() const {
+    const std::vector<double>& getAngles() const {
+        if (!metrics.has_angles) {
+            metrics.angles = computeAngles();
+            metrics.has_angles = true;
+        }
+        return metrics.angles;
+    }
+
+    std::vector<double> computeAngles() const {
         std::vector<double> angles;
         int n = vertices.size();
         for (int i = 0; i < n; ++i) {
@@ -350,7 +526,7 @@ public:
         if (vertices.size() != polygon_pointer->vertices.size()) {
       		return false;
     	}
-		std::vector<double> angles1 = getAngles();
+		const std::vector<double>& angles1 = getAngles();
         std::vector<double> angles2 = polygon_pointer->getAngles();
         for (size_t i = 0; i < angles1.size(); i++) {
           for (size_t j = 0; j < angles2.size(); j++) {
@@ -392,6 +568,11 @@ public:
         Vector P1M(p1, point);
         Vector MP1(point, p1);
         Vector MP2(point, p2);
+        if (predicate_policy == PredicatePolicy::kExact) {
+          return orientation(p1, p2, point) == 0
+                 && std::min(p1.x, p2.x) <= point.x && point.x <= std::max(p1.x, p2.x)
+                 && std::min(p1.y, p2.y) <= point.y && point.y <= std::max(p1.y, p2.y);
+        }
         return P1P2.x * P1M.y - P1P2.y * P1M.x == 0 && MP1.x * MP2.x + MP1.y * MP2.y <= 0;
     }
 
@@ -401,9 +582,18 @@ public:
         for (int i = 0; i < n; i++) {
             const Point pi = vertices[(i + 1) % n];
             const Point pj = vertices[i];
-            if ((pi.y > point.y) != (pj.y > point.y)
-                    && (point.x < (pj.x - pi.x) * (point.y - pi.y) / (pj.y - pi.y) + pi.x)) {
-                inside = !inside;
+            if ((pi.y > point.y) != (pj.y > point.y)) {
+                bool crosses = false;
+                if (predicate_policy == PredicatePolicy::kExact) {
+                    // The ray to the right crosses the edge iff the point lies on its left
+                    // when the edge is walked upwards.
+                    crosses = orientation(pi, pj, point) == (pj.y > pi.y ? 1 : -1);
+                } else {
+                    crosses = point.x < (pj.x - pi.x) * (point.y - pi.y) / (pj.y - pi.y) + pi.x;
+                }
+                if (crosses) {
+                    inside = !inside;
+                }
             }
             if (isPointOnSegment(point, pi, pj)) {
                 return true;
@@ -416,24 +606,53 @@ public:
       for (Point& point : vertices) {
     	point.rotate(center, angle);
  	  }
+      metrics.centroid.rotate(center, angle);
+      metrics.has_bounding_box = false;
     }
 
     void reflect(const Point& center) override {
       for (Point& point : vertices) {
     	point.reflect(center);
   	  }
+      metrics.centroid.reflect(center);
+      Point min = metrics.bounding_box.min;
+      Point max = metrics.bounding_box.max;
+      min.reflect(center);
+      max.reflect(center);
+      metrics.bounding_box = BoundingBox(max, min);
     }
 
     void reflect(const Line& axis) override {
       for (Point& point : vertices) {
     	point.reflect(axis);
  	  }
+      metrics.centroid.reflect(axis);
+      metrics.has_bounding_box = false;
     }
 
     void scale(const Point& center, double coefficient) override {
       for (Point& point : vertices) {
     	point.scale(center, coefficient);
   	  }
+      double factor = std::abs(coefficient);
+      metrics.area *= coefficient * coefficient;
+      metrics.perimeter *= factor;
+      for (double& length : metrics.side_lengths) {
+        length *= factor;
+      }
+      metrics.centroid.scale(center, coefficient);
+      Point min = metrics.bounding_box.min;
+      Point max = metrics.bounding_box.max;
+      min.scale(center, coefficient);
+      max.scale(center, coefficient);
+      metrics.bounding_box = BoundingBox(min, min);
+      metrics.bounding_box.expand(max);
+      if (coefficient < 0 || coefficient > 0) {
+        return;
+      }
+      // Collapsed onto the center: angles and convexity no longer mean much.
+      metrics.has_angles = false;
+      metrics.has_convexity = false;
     }
 
     bool isEquals(const Shape& polygon2) const {
@@ -480,9 +699,60 @@ public:
   Point focus2;
   double sum_distances;
 
+private:
+  // The members above are public, so the cache remembers the values it was
+  // computed from and is trusted only while they still match.
+  struct Metrics {
+    Point focus1{};
+    Point focus2{};
+    double sum_distances = 0.0;
+    bool valid = false;
+
+    std::pair<double, double> semiaxis{};
+    double perimeter = 0.0;
+    double area = 0.0;
+  };
+
+  mutable Metrics metrics;
+
+  static bool same(double a, double b) {
+    return !(a < b) && !(b < a);
+  }
+
+  bool upToDate() const {
+    return metrics.valid && same(metrics.sum_distances, sum_distances)
+           && same(metrics.focus1.x, focus1.x) && same(metrics.focus1.y, focus1.y)
+           && same(metrics.focus2.x, focus2.x) && same(metrics.focus2.y, focus2.y);
+  }
+
+  const Metrics& cached() const {
+    if (!upToDate()) {
+      double a = sum_distances / 2; // Большая полуось
+      double d = std::sqrt(std::pow(focus2.x - focus1.x, 2) + std::pow(focus2.y - focus1.y, 2));
+      double b = std::sqrt(std::pow(a, 2) - std::pow(d / 2, 2)); // Малая полуось
+      metrics.semiaxis = {a, b};
+      metrics.perimeter = M_PI * (3 * (a + b) - std::sqrt((3 * a + b) * (a + 3 * b)));
+      metrics.area = M_PI * a * b;
+      metrics.focus1 = focus1;
+      metrics.focus2 = focus2;
+      metrics.sum_distances = sum_distances;
+      metrics.valid = true;
+    }
+    return metrics;
+  }
+
+  // After a rigid motion the cached metrics still describe the moved ellipse.
+  void keepMetrics(bool up_to_date) {
+    if (up_to_date) {
+      metrics.focus1 = focus1;
+      metrics.focus2 = focus2;
+      metrics.sum_distances = sum_distances;
+    }
+  }
+
 public:
   Ellipse(const Point& f1, const Point& f2, double sum_distances)
-        : focus1(f1), focus2(f2), sum_distances(sum_distances) {}
+        : focus1(f1), focus2(f2), sum_distances(sum_distances), metrics() {}
 
   double getSumDistances() const {
     return sum_distances;
@@ -497,10 +767,7 @@ public:
   }
 
   std::pair<double, double> semiaxis() const {
-    double a = sum_distances / 2; // Большая полуось
-    double d = std::sqrt(std::pow(focus2.x - focus1.x, 2) + std::pow(focus2.y - focus1.y, 2));
-    double b = std::sqrt(std::pow(a, 2) - std::pow(d / 2, 2)); // Малая полуось
-    return {a, b};
+    return cached().semiaxis;
   }
 
   std::pair<Point, Point> focuses() const {
@@ -529,18 +796,11 @@ public:
   }
 
   double perimeter() const override {
-    std::pair<double, double> semiaxises = semiaxis();
-    double a = semiaxises.first;
-    double b = semiaxises.second;
-    double perimeter_value = M_PI * (3 * (a + b) - std::sqrt((3 * a + b) * (a + 3 * b)));
-    return perimeter_value;
+    return cached().perimeter;
   }
 
   double area() const override {
-    double a = sum_distances / 2;
-    double d = std::sqrt(std::pow(focus2.x - focus1.x, 2) + std::pow(focus2.y - focus1.y, 2));
-    double b = std::sqrt(std::pow(a, 2) - std::pow(d / 2, 2));
-    return M_PI * a * b;
+    return cached().area;
   }
 
   bool isCongruentTo(const Shape& another) const override {
@@ -576,24 +836,38 @@ public:
   }
 
   void rotate(const Point& center, double angle) override {
+    bool up_to_date = upToDate();
 	focus1.rotate(center, angle);
   	focus2.rotate(center, angle);
+    keepMetrics(up_to_date);
   }
 
   void reflect(const Point& center) override {
+    bool up_to_date = upToDate();
 	focus1.reflect(center);
   	focus2.reflect(center);
+    keepMetrics(up_to_date);
   }
 
   void reflect(const Line& axis) override {
+    bool up_to_date = upToDate();
 	focus1.reflect(axis);
   	focus2.reflect(axis);
+    keepMetrics(up_to_date);
   }
 
   void scale(const Point& center, double coefficient) override {
+    bool up_to_date = upToDate() && coefficient > 0;
     sum_distances *= coefficient;
     focus1.scale(center, coefficient);
     focus2.scale(center, coefficient);
+    if (up_to_date) {
+      metrics.semiaxis.first *= coefficient;
+      metrics.semiaxis.second *= coefficient;
+      metrics.perimeter *= coefficient;
+      metrics.area *= coefficient * coefficient;
+    }
+    keepMetrics(up_to_date);
   }
 
   bool isEquals(const Shape& ellipse2) const;
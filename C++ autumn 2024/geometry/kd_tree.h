@@ -0,0 +1,327 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "geometry.h"
+
+/*
+ * Static 2-d tree over a batch of points, stored implicitly in one flat array:
+ * the node of range [begin, end) is the median element (begin + end) / 2, its
+ * children are the two halves, and the splitting axis alternates with depth.
+ * There are no node pointers, so a query touches only the point array.
+ *
+ * All queries return indices into the vector the tree was built from.
+ */
+class KdTree {
+public:
+  static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+private:
+  struct Entry {
+    Point point;
+    size_t index;
+  };
+
+  static constexpr size_t kParallelCutoff = 1 << 16;
+
+  std::vector<Entry> entries_;
+
+  static double coordinate(const Point& point, size_t axis) {
+    return axis == 0 ? point.x : point.y;
+  }
+
+  static double squaredDistance(const Point& a, const Point& b) {
+    return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y);
+  }
+
+  void build(size_t begin, size_t end, size_t axis, size_t spare_threads);
+
+  void nearest(size_t begin, size_t end, size_t axis, const Point& point,
+               size_t& best, double& best_distance) const;
+
+  void kNearest(size_t begin, size_t end, size_t axis, const Point& point, size_t k,
+                std::priority_queue<std::pair<double, size_t>>& heap) const;
+
+  void radius(size_t begin, size_t end, size_t axis, const Point& point, double radius_squared,
+              std::vector<size_t>& result) const;
+
+  void range(size_t begin, size_t end, size_t axis, const BoundingBox& box, std::vector<size_t>& result) const;
+
+public:
+  // threads = 0 picks std::thread::hardware_concurrency().
+  explicit KdTree(const std::vector<Point>& points, size_t threads = 1);
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+  bool empty() const {
+    return entries_.empty();
+  }
+
+  size_t nearest(const Point& point) const;
+
+  // The k closest points, nearest first.
+  std::vector<size_t> kNearest(const Point& point, size_t k) const;
+
+  std::vector<size_t> radius(const Point& point, double radius) const;
+
+  std::vector<size_t> range(const BoundingBox& box) const;
+};
+
+KdTree::KdTree(const std::vector<Point>& points, size_t threads) : entries_() {
+  entries_.reserve(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    entries_.push_back({points[i], i});
+  }
+  if (threads == 0) {
+    threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+  build(0, entries_.size(), 0, threads - 1);
+}
+
+void KdTree::build(size_t begin, size_t end, size_t axis, size_t spare_threads) {
+  if (end - begin <= 1) {
+    return;
+  }
+  size_t middle = begin + (end - begin) / 2;
+  auto first = entries_.begin();
+  std::nth_element(first + static_cast<std::ptrdiff_t>(begin), first + static_cast<std::ptrdiff_t>(middle),
+                   first + static_cast<std::ptrdiff_t>(end), [axis](const Entry& a, const Entry& b) {
+                     return coordinate(a.point, axis) < coordinate(b.point, axis);
+                   });
+
+  if (spare_threads > 0 && end - begin >= kParallelCutoff) {
+    // Hand the left half to a new thread together with half of the spare ones.
+    size_t left_threads = (spare_threads - 1) / 2;
+    std::thread left([this, begin, middle, axis, left_threads]() {
+      build(begin, middle, 1 - axis, left_threads);
+    });
+    build(middle + 1, end, 1 - axis, spare_threads - 1 - left_threads);
+    left.join();
+    return;
+  }
+  build(begin, middle, 1 - axis, 0);
+  build(middle + 1, end, 1 - axis, 0);
+}
+
+void KdTree::nearest(size_t begin, size_t end, size_t axis, const Point& point,
+                     size_t& best, double& best_distance) const {
+  if (begin >= end) {
+    return;
+  }
+  size_t middle = begin + (end - begin) / 2;
+  const Entry& entry = entries_[middle];
+  double distance = squaredDistance(entry.point, point);
+  if (distance < best_distance) {
+    best_distance = distance;
+    best = entry.index;
+  }
+
+  double delta = coordinate(point, axis) - coordinate(entry.point, axis);
+  if (delta < 0) {
+    nearest(begin, middle, 1 - axis, point, best, best_distance);
+    if (delta * delta < best_distance) {
+      nearest(middle + 1, end, 1 - axis, point, best, best_distance);
+    }
+  } else {
+    nearest(middle + 1, end, 1 - axis, point, best, best_distance);
+    if (delta * delta < best_distance) {
+      nearest(begin, middle, 1 - axis, point, best, best_distance);
+    }
+  }
+}
+
+size_t KdTree::nearest(const Point& point) const {
+  size_t best = kNone;
+  double best_distance = std::numeric_limits<double>::infinity();
+  nearest(0, entries_.size(), 0, point, best, best_distance);
+  return best;
+}
+
+void KdTree::kNearest(size_t begin, size_t end, size_t axis, const Point& point, size_t k,
+                      std::priority_queue<std::pair<double, size_t>>& heap) const {
+  if (begin >= end) {
+    return;
+  }
+  size_t middle = begin + (end - begin) / 2;
+  const Entry& entry = entries_[middle];
+  double distance = squaredDistance(entry.point, point);
+  if (heap.size() < k) {
+    heap.emplace(distance, entry.index);
+  } else if (distance < heap.top().first) {
+    heap.pop();
+    heap.emplace(distance, entry.index);
+  }
+
+  double delta = coordinate(point, axis) - coordinate(entry.point, axis);
+  size_t near_begin = delta < 0 ? begin : middle + 1;
+  size_t near_end = delta < 0 ? middle : end;
+  size_t far_begin = delta < 0 ? middle + 1 : begin;
+  size_t far_end = delta < 0 ? end : middle;
+  kNearest(near_begin, near_end, 1 - axis, point, k, heap);
+  if (heap.size() < k || delta * delta < heap.top().first) {
+    kNearest(far_begin, far_end, 1 - axis, point, k, heap);
+  }
+}
+
+std::vector<size_t> KdTree::kNearest(const Point& point, size_t k) const {
+  std::vector<size_t> result;
+  if (k == 0) {
+    return result;
+  }
+  std::priority_queue<std::pair<double, size_t>> heap;
+  kNearest(0, entries_.size(), 0, point, k, heap);
+  result.resize(heap.size());
+  for (size_t i = result.size(); i-- > 0;) {
+    result[i] = heap.top().second;
+    heap.pop();
+  }
+  return result;
+}
+
+void KdTree::radius(size_t begin, size_t end, size_t axis, const Point& point, double radius_squared,
+                    std::vector<size_t>& result) const {
+  if (begin >= end) {
+    return;
+  }
+  size_t middle = begin + (end - begin) / 2;
+  const Entry& entry = entries_[middle];
+  if (squaredDistance(entry.point, point) <= radius_squared) {
+    result.push_back(entry.index);
+  }
+  double delta = coordinate(point, axis) - coordinate(entry.point, axis);
+  if (delta <= 0 || delta * delta <= radius_squared) {
+    radius(begin, middle, 1 - axis, point, radius_squared, result);
+  }
+  if (delta >= 0 || delta * delta <= radius_squared) {
+    radius(middle + 1, end, 1 - axis, point, radius_squared, result);
+  }
+}
+
+std::vector<size_t> KdTree::radius(const Point& point, double radius) const {
+  std::vector<size_t> result;
+  this->radius(0, entries_.size(), 0, point, radius * radius, result);
+  return result;
+}
+
+void KdTree::range(size_t begin, size_t end, size_t axis, const BoundingBox& box,
+                   std::vector<size_t>& result) const {
+  if (begin >= end) {
+    return;
+  }
+  size_t middle = begin + (end - begin) / 2;
+  const Entry& entry = entries_[middle];
+  if (box.containsPoint(entry.point)) {
+    result.push_back(entry.index);
+  }
+  double split = coordinate(entry.point, axis);
+  if (coordinate(box.min, axis) <= split) {
+    range(begin, middle, 1 - axis, box, result);
+  }
+  if (coordinate(box.max, axis) >= split) {
+    range(middle + 1, end, 1 - axis, box, result);
+  }
+}
+
+std::vector<size_t> KdTree::range(const BoundingBox& box) const {
+  std::vector<size_t> result;
+  range(0, entries_.size(), 0, box, result);
+  return result;
+}
+
+namespace detail {
+
+struct IndexedPoint {
+  Point point;
+  size_t index;
+};
+
+// Closest pair among items[begin, end), which is sorted by x on entry and left
+// sorted by y on exit (the merge step of the classic divide and conquer).
+inline void closestPair(std::vector<IndexedPoint>& items, std::vector<IndexedPoint>& buffer, size_t begin,
+                        size_t end, std::pair<size_t, size_t>& best, double& best_distance) {
+  auto by_y = [](const IndexedPoint& a, const IndexedPoint& b) { return a.point.y < b.point.y; };
+  auto squared = [](const IndexedPoint& a, const IndexedPoint& b) {
+    return (a.point.x - b.point.x) * (a.point.x - b.point.x) + (a.point.y - b.point.y) * (a.point.y - b.point.y);
+  };
+  auto first = items.begin();
+
+  if (end - begin <= 3) {
+    for (size_t i = begin; i < end; ++i) {
+      for (size_t j = i + 1; j < end; ++j) {
+        double distance = squared(items[i], items[j]);
+        if (distance < best_distance) {
+          best_distance = distance;
+          best = {items[i].index, items[j].index};
+        }
+      }
+    }
+    std::sort(first + static_cast<std::ptrdiff_t>(begin), first + static_cast<std::ptrdiff_t>(end), by_y);
+    return;
+  }
+
+  size_t middle = begin + (end - begin) / 2;
+  double middle_x = items[middle].point.x;
+  closestPair(items, buffer, begin, middle, best, best_distance);
+  closestPair(items, buffer, middle, end, best, best_distance);
+
+  buffer.resize(end - begin);
+  std::merge(first + static_cast<std::ptrdiff_t>(begin), first + static_cast<std::ptrdiff_t>(middle),
+             first + static_cast<std::ptrdiff_t>(middle), first + static_cast<std::ptrdiff_t>(end),
+             buffer.begin(), by_y);
+  std::copy(buffer.begin(), buffer.end(), first + static_cast<std::ptrdiff_t>(begin));
+
+  // Only points of the vertical strip around the split can improve the answer,
+  // and each of them has a constant number of strip neighbours below it.
+  buffer.clear();
+  for (size_t i = begin; i < end; ++i) {
+    double dx = items[i].point.x - middle_x;
+    if (dx * dx >= best_distance) {
+      continue;
+    }
+    for (size_t j = buffer.size(); j-- > 0;) {
+      double dy = items[i].point.y - buffer[j].point.y;
+      if (dy * dy >= best_distance) {
+        break;
+      }
+      double distance = squared(items[i], buffer[j]);
+      if (distance < best_distance) {
+        best_distance = distance;
+        best = {buffer[j].index, items[i].index};
+      }
+    }
+    buffer.push_back(items[i]);
+  }
+}
+
+}  // namespace detail
+
+// Indices of the two closest points, O(n log n). Returns {kNone, kNone} for
+// fewer than two points.
+std::pair<size_t, size_t> closestPair(const std::vector<Point>& points) {
+  std::pair<size_t, size_t> best(KdTree::kNone, KdTree::kNone);
+  if (points.size() < 2) {
+    return best;
+  }
+  std::vector<detail::IndexedPoint> items;
+  items.reserve(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    items.push_back({points[i], i});
+  }
+  std::sort(items.begin(), items.end(), [](const detail::IndexedPoint& a, const detail::IndexedPoint& b) {
+    return a.point.x < b.point.x || (!(b.point.x < a.point.x) && a.point.y < b.point.y);
+  });
+  std::vector<detail::IndexedPoint> buffer;
+  buffer.reserve(points.size());
+  double best_distance = std::numeric_limits<double>::infinity();
+  detail::closestPair(items, buffer, 0, items.size(), best, best_distance);
+  return best;
+}
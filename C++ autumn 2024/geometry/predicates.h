@@ -0,0 +1,257 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/*
+ * Adaptive-precision geometric predicates in the spirit of Shewchuk's
+ * "Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric
+ * Predicates". Every predicate first evaluates the determinant in plain
+ * doubles together with a forward error bound; only when the sign cannot be
+ * certified is the determinant recomputed exactly with floating-point
+ * expansions.
+ */
+
+enum class PredicatePolicy {
+  kEpsilon,  // plain double arithmetic as in the baseline: strict cross-product signs
+  kExact     // exact signs through orient2d/incircle
+};
+
+inline PredicatePolicy predicate_policy = PredicatePolicy::kEpsilon;
+
+namespace detail {
+
+// A floating-point expansion: nonoverlapping components sorted by increasing
+// magnitude, whose exact sum is the represented value.
+using Expansion = std::vector<double>;
+
+constexpr double kEpsilon = 1.1102230246251565e-16;  // 2^-53
+constexpr double kOrientBoundA = (3.0 + 16.0 * kEpsilon) * kEpsilon;
+constexpr double kIncircleBoundA = (10.0 + 96.0 * kEpsilon) * kEpsilon;
+
+inline bool nonZero(double value) {
+  return value < 0.0 || value > 0.0;
+}
+
+inline void twoSum(double a, double b, double& sum, double& error) {
+  sum = a + b;
+  double b_virtual = sum - a;
+  double a_virtual = sum - b_virtual;
+  error = (a - a_virtual) + (b - b_virtual);
+}
+
+inline void fastTwoSum(double a, double b, double& sum, double& error) {
+  sum = a + b;
+  error = b - (sum - a);
+}
+
+inline void twoProduct(double a, double b, double& product, double& error) {
+  product = a * b;
+  error = std::fma(a, b, -product);
+}
+
+inline Expansion twoDiffExpansion(double a, double b) {
+  double sum = 0.0;
+  double error = 0.0;
+  twoSum(a, -b, sum, error);
+  Expansion result;
+  if (nonZero(error)) {
+    result.push_back(error);
+  }
+  if (nonZero(sum)) {
+    result.push_back(sum);
+  }
+  return result;
+}
+
+inline Expansion growExpansion(const Expansion& expansion, double value) {
+  Expansion result;
+  result.reserve(expansion.size() + 1);
+  double carry = value;
+  for (double component : expansion) {
+    double sum = 0.0;
+    double error = 0.0;
+    twoSum(carry, component, sum, error);
+    if (nonZero(error)) {
+      result.push_back(error);
+    }
+    carry = sum;
+  }
+  if (nonZero(carry)) {
+    result.push_back(carry);
+  }
+  return result;
+}
+
+inline Expansion expansionSum(const Expansion& first, const Expansion& second) {
+  Expansion result = first;
+  for (double component : second) {
+    result = growExpansion(result, component);
+  }
+  return result;
+}
+
+inline Expansion negate(Expansion expansion) {
+  for (double& component : expansion) {
+    component = -component;
+  }
+  return expansion;
+}
+
+inline Expansion scaleExpansion(const Expansion& expansion, double value) {
+  Expansion result;
+  if (expansion.empty() || !nonZero(value)) {
+    return result;
+  }
+  result.reserve(2 * expansion.size());
+  double carry = 0.0;
+  double error = 0.0;
+  twoProduct(expansion[0], value, carry, error);
+  if (nonZero(error)) {
+    result.push_back(error);
+  }
+  for (size_t i = 1; i < expansion.size(); ++i) {
+    double product = 0.0;
+    double product_error = 0.0;
+    twoProduct(expansion[i], value, product, product_error);
+    double sum = 0.0;
+    twoSum(carry, product_error, sum, error);
+    if (nonZero(error)) {
+      result.push_back(error);
+    }
+    fastTwoSum(product, sum, carry, error);
+    if (nonZero(error)) {
+      result.push_back(error);
+    }
+  }
+  if (nonZero(carry)) {
+    result.push_back(carry);
+  }
+  return result;
+}
+
+inline Expansion expansionProduct(const Expansion& first, const Expansion& second) {
+  Expansion result;
+  for (double component : second) {
+    result = expansionSum(result, scaleExpansion(first, component));
+  }
+  return result;
+}
+
+// The largest component carries the sign of the whole expansion.
+inline double estimate(const Expansion& expansion) {
+  double result = 0.0;
+  for (double component : expansion) {
+    result += component;
+  }
+  return result;
+}
+
+inline double orient2dExact(double ax, double ay, double bx, double by, double cx, double cy) {
+  // (ax - cx)(by - cy) - (ay - cy)(bx - cx) expanded into six exact products.
+  const double terms[6][2] = {{ax, by}, {-ax, cy}, {-cx, by}, {-ay, bx}, {ay, cx}, {cy, bx}};
+  Expansion sum;
+  for (const auto& term : terms) {
+    double product = 0.0;
+    double error = 0.0;
+    twoProduct(term[0], term[1], product, error);
+    sum = growExpansion(sum, error);
+    sum = growExpansion(sum, product);
+  }
+  return sum.empty() ? 0.0 : sum.back();
+}
+
+inline double incircleExact(double ax, double ay, double bx, double by,
+                            double cx, double cy, double dx, double dy) {
+  Expansion adx = twoDiffExpansion(ax, dx);
+  Expansion ady = twoDiffExpansion(ay, dy);
+  Expansion bdx = twoDiffExpansion(bx, dx);
+  Expansion bdy = twoDiffExpansion(by, dy);
+  Expansion cdx = twoDiffExpansion(cx, dx);
+  Expansion cdy = twoDiffExpansion(cy, dy);
+
+  Expansion a_lift = expansionSum(expansionProduct(adx, adx), expansionProduct(ady, ady));
+  Expansion b_lift = expansionSum(expansionProduct(bdx, bdx), expansionProduct(bdy, bdy));
+  Expansion c_lift = expansionSum(expansionProduct(cdx, cdx), expansionProduct(cdy, cdy));
+
+  Expansion bc = expansionSum(expansionProduct(bdx, cdy), negate(expansionProduct(cdx, bdy)));
+  Expansion ca = expansionSum(expansionProduct(cdx, ady), negate(expansionProduct(adx, cdy)));
+  Expansion ab = expansionSum(expansionProduct(adx, bdy), negate(expansionProduct(bdx, ady)));
+
+  Expansion det = expansionSum(expansionProduct(a_lift, bc), expansionProduct(b_lift, ca));
+  det = expansionSum(det, expansionProduct(c_lift, ab));
+  return det.empty() ? 0.0 : det.back();
+}
+
+}  // namespace detail
+
+// Positive if a, b, c make a counterclockwise turn, negative if clockwise,
+// zero if they are collinear. The sign is always exact.
+inline double orient2d(double ax, double ay, double bx, double by, double cx, double cy) {
+  double det_left = (ax - cx) * (by - cy);
+  double det_right = (ay - cy) * (bx - cx);
+  double det = det_left - det_right;
+  double det_sum = 0.0;
+
+  if (det_left > 0.0) {
+    if (det_right <= 0.0) {
+      return det;
+    }
+    det_sum = det_left + det_right;
+  } else if (det_left < 0.0) {
+    if (det_right >= 0.0) {
+      return det;
+    }
+    det_sum = -det_left - det_right;
+  } else {
+    return det;
+  }
+
+  if (std::abs(det) >= detail::kOrientBoundA * det_sum) {
+    return det;
+  }
+  return detail::orient2dExact(ax, ay, bx, by, cx, cy);
+}
+
+// Positive if d lies inside the circle through a, b, c (given counterclockwise),
+// negative if outside, zero if the four points are cocircular.
+inline double incircle(double ax, double ay, double bx, double by,
+                       double cx, double cy, double dx, double dy) {
+  double adx = ax - dx;
+  double ady = ay - dy;
+  double bdx = bx - dx;
+  double bdy = by - dy;
+  double cdx = cx - dx;
+  double cdy = cy - dy;
+
+  double bdx_cdy = bdx * cdy;
+  double cdx_bdy = cdx * bdy;
+  double a_lift = adx * adx + ady * ady;
+
+  double cdx_ady = cdx * ady;
+  double adx_cdy = adx * cdy;
+  double b_lift = bdx * bdx + bdy * bdy;
+
+  double adx_bdy = adx * bdy;
+  double bdx_ady = bdx * ady;
+  double c_lift = cdx * cdx + cdy * cdy;
+
+  double det = a_lift * (bdx_cdy - cdx_bdy) + b_lift * (cdx_ady - adx_cdy) + c_lift * (adx_bdy - bdx_ady);
+  double permanent = (std::abs(bdx_cdy) + std::abs(cdx_bdy)) * a_lift
+                     + (std::abs(cdx_ady) + std::abs(adx_cdy)) * b_lift
+                     + (std::abs(adx_bdy) + std::abs(bdx_ady)) * c_lift;
+
+  if (std::abs(det) > detail::kIncircleBoundA * permanent) {
+    return det;
+  }
+  return detail::incircleExact(ax, ay, bx, by, cx, cy, dx, dy);
+}
+
+// a * d - b * c with a single rounding error (Kahan's 2x2 determinant).
+inline double det2(double a, double b, double c, double d) {
+  double bc = b * c;
+  double error = std::fma(-b, c, bc);
+  double result = std::fma(a, d, -bc);
+  return result + error;
+}
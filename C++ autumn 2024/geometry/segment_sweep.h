@@ -0,0 +1,523 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "geometry.h"
+#include "predicates.h"
+
+struct Segment {
+  Point begin;
+  Point end;
+
+  Segment(const Point& from, const Point& to) : begin(from), end(to) {}
+
+  Line line() const {
+    return Line(begin, end);
+  }
+};
+
+struct SegmentIntersection {
+  Point point;
+  std::vector<size_t> segments;
+};
+
+namespace detail {
+
+inline bool lexLess(const Point& a, const Point& b) {
+  return a.x < b.x || (!(b.x < a.x) && a.y < b.y);
+}
+
+inline bool samePoint(const Point& a, const Point& b) {
+  return !lexLess(a, b) && !lexLess(b, a);
+}
+
+inline int orientationSign(const Point& a, const Point& b, const Point& c) {
+  double det = orient2d(a.x, a.y, b.x, b.y, c.x, c.y);
+  return (det > 0) - (det < 0);
+}
+
+inline int expansionSign(const Expansion& expansion) {
+  return expansion.empty() ? 0 : (expansion.back() > 0 ? 1 : -1);
+}
+
+// A bound on how far estimate() of the expansion may be from its value.
+inline double estimateError(const Expansion& expansion) {
+  double magnitude = 0.0;
+  for (double component : expansion) {
+    magnitude += std::abs(component);
+  }
+  return 2.0 * static_cast<double>(expansion.size() + 1) * kEpsilon * magnitude;
+}
+
+/*
+ * An event point held exactly as (x / w, y / w) with w > 0: input endpoints
+ * have w = 1, crossings of two segments are ratios of expansions. The
+ * estimates and their error bounds settle most comparisons in doubles; the
+ * expansions are only multiplied out when those cannot.
+ */
+struct SweepPoint {
+  Point point;  // rounded once, for reporting
+  bool endpoint;
+  Expansion x;
+  Expansion y;
+  Expansion w;
+  double x_estimate;
+  double y_estimate;
+  double w_estimate;
+  double x_error;
+  double y_error;
+  double w_error;
+
+  explicit SweepPoint(const Point& from)
+      : point(from), endpoint(true), x(), y(), w(1, 1.0), x_estimate(from.x), y_estimate(from.y),
+        w_estimate(1.0), x_error(0.0), y_error(0.0), w_error(0.0) {
+    if (nonZero(from.x)) {
+      x.push_back(from.x);
+    }
+    if (nonZero(from.y)) {
+      y.push_back(from.y);
+    }
+  }
+
+  SweepPoint(Expansion x_numerator, Expansion y_numerator, Expansion denominator)
+      : point(), endpoint(false), x(std::move(x_numerator)), y(std::move(y_numerator)), w(std::move(denominator)),
+        x_estimate(), y_estimate(), w_estimate(), x_error(), y_error(), w_error() {
+    if (expansionSign(w) < 0) {
+      x = negate(x);
+      y = negate(y);
+      w = negate(w);
+    }
+    x_estimate = estimate(x);
+    y_estimate = estimate(y);
+    w_estimate = estimate(w);
+    x_error = estimateError(x);
+    y_error = estimateError(y);
+    w_error = estimateError(w);
+    point = Point(x_estimate / w_estimate, y_estimate / w_estimate);
+  }
+};
+
+// Sign of a.x / a.w - b.x / b.w, or of the y version with by_y.
+inline int compareCoordinate(const SweepPoint& a, const SweepPoint& b, bool by_y) {
+  double a_value = by_y ? a.y_estimate : a.x_estimate;
+  double b_value = by_y ? b.y_estimate : b.x_estimate;
+  if (a.endpoint && b.endpoint) {
+    return (a_value > b_value) - (a_value < b_value);
+  }
+  double a_error = by_y ? a.y_error : a.x_error;
+  double b_error = by_y ? b.y_error : b.x_error;
+  double left = a_value * b.w_estimate;
+  double right = b_value * a.w_estimate;
+  double difference = left - right;
+  double bound = 8.0 * kEpsilon * (std::abs(left) + std::abs(right))
+                 + 2.0 * (std::abs(a_value) * b.w_error + a_error * (std::abs(b.w_estimate) + b.w_error)
+                          + std::abs(b_value) * a.w_error + b_error * (std::abs(a.w_estimate) + a.w_error));
+  if (std::abs(difference) > bound) {
+    return difference > 0 ? 1 : -1;
+  }
+  const Expansion& a_exact = by_y ? a.y : a.x;
+  const Expansion& b_exact = by_y ? b.y : b.x;
+  return expansionSign(expansionSum(expansionProduct(a_exact, b.w), negate(expansionProduct(b_exact, a.w))));
+}
+
+inline bool lexLess(const SweepPoint& a, const SweepPoint& b) {
+  int x_order = compareCoordinate(a, b, false);
+  return x_order < 0 || (x_order == 0 && compareCoordinate(a, b, true) < 0);
+}
+
+// orientationSign(a, b, c) for an exact event point c.
+inline int orientationSign(const Point& a, const Point& b, const SweepPoint& c) {
+  if (c.endpoint) {
+    return orientationSign(a, b, c.point);
+  }
+  // (b - a) x (c - a), scaled by w > 0.
+  double dx = b.x - a.x;
+  double dy = b.y - a.y;
+  double y_offset = c.y_estimate - c.w_estimate * a.y;
+  double x_offset = c.x_estimate - c.w_estimate * a.x;
+  double det = dx * y_offset - dy * x_offset;
+  double magnitude = std::abs(dx) * (std::abs(c.y_estimate) + std::abs(c.w_estimate * a.y))
+                     + std::abs(dy) * (std::abs(c.x_estimate) + std::abs(c.w_estimate * a.x));
+  double error = std::abs(dx) * (c.y_error + std::abs(a.y) * c.w_error)
+                 + std::abs(dy) * (c.x_error + std::abs(a.x) * c.w_error);
+  if (std::abs(det) > 16.0 * kEpsilon * magnitude + 2.0 * error) {
+    return det > 0 ? 1 : -1;
+  }
+  Expansion exact_y = expansionSum(c.y, negate(scaleExpansion(c.w, a.y)));
+  Expansion exact_x = expansionSum(c.x, negate(scaleExpansion(c.w, a.x)));
+  return expansionSign(expansionSum(expansionProduct(twoDiffExpansion(b.x, a.x), exact_y),
+                                    negate(expansionProduct(twoDiffExpansion(b.y, a.y), exact_x))));
+}
+
+// The crossing point of two non-parallel segments, exactly, as a ratio of
+// expansions: segments through one point all produce that same point.
+inline SweepPoint crossingPoint(const Segment& s, const Segment& t) {
+  auto cross = [](const Expansion& ax, const Expansion& ay, const Expansion& bx, const Expansion& by) {
+    return expansionSum(expansionProduct(ax, by), negate(expansionProduct(ay, bx)));
+  };
+  Expansion rx = twoDiffExpansion(s.end.x, s.begin.x);
+  Expansion ry = twoDiffExpansion(s.end.y, s.begin.y);
+  Expansion ux = twoDiffExpansion(t.end.x, t.begin.x);
+  Expansion uy = twoDiffExpansion(t.end.y, t.begin.y);
+  Expansion wx = twoDiffExpansion(t.begin.x, s.begin.x);
+  Expansion wy = twoDiffExpansion(t.begin.y, s.begin.y);
+  // s.begin + r * (w x u) / (r x u), over the common denominator.
+  Expansion numerator = cross(wx, wy, ux, uy);
+  Expansion denominator = cross(rx, ry, ux, uy);
+  Expansion x = expansionSum(scaleExpansion(denominator, s.begin.x), expansionProduct(rx, numerator));
+  Expansion y = expansionSum(scaleExpansion(denominator, s.begin.y), expansionProduct(ry, numerator));
+  return SweepPoint(std::move(x), std::move(y), std::move(denominator));
+}
+
+// Exact sign of (s.end - s.begin) x (t.end - t.begin): positive if t turns
+// counterclockwise from s. The differences are not rounded first, so nearly
+// parallel segments are told apart.
+inline int directionTurn(const Segment& s, const Segment& t) {
+  double left = (s.end.x - s.begin.x) * (t.end.y - t.begin.y);
+  double right = (s.end.y - s.begin.y) * (t.end.x - t.begin.x);
+  double det = left - right;
+  if (std::abs(det) > 8.0 * kEpsilon * (std::abs(left) + std::abs(right))) {
+    return det > 0 ? 1 : -1;
+  }
+  return expansionSign(expansionSum(
+      expansionProduct(twoDiffExpansion(s.end.x, s.begin.x), twoDiffExpansion(t.end.y, t.begin.y)),
+      negate(expansionProduct(twoDiffExpansion(s.end.y, s.begin.y), twoDiffExpansion(t.end.x, t.begin.x)))));
+}
+
+// Whether the segments cross at a point interior to both.
+inline bool properlyCross(const Segment& s, const Segment& t) {
+  return orientationSign(t.begin, t.end, s.begin) * orientationSign(t.begin, t.end, s.end) < 0
+         && orientationSign(s.begin, s.end, t.begin) * orientationSign(s.begin, s.end, t.end) < 0;
+}
+
+// Exact intersection test. On success stores in point the lexicographically
+// smallest common point for collinear overlaps, the shared point otherwise.
+inline bool segmentsIntersect(const Segment& s, const Segment& t, Point& point) {
+  if (samePoint(s.begin, s.end) || samePoint(t.begin, t.end)) {
+    // A degenerate segment meets the other one only if it lies on it.
+    const Segment& dot = samePoint(s.begin, s.end) ? s : t;
+    const Segment& other = samePoint(s.begin, s.end) ? t : s;
+    point = dot.begin;
+    return orientationSign(other.begin, other.end, point) == 0
+           && std::min(other.begin.x, other.end.x) <= point.x && point.x <= std::max(other.begin.x, other.end.x)
+           && std::min(other.begin.y, other.end.y) <= point.y && point.y <= std::max(other.begin.y, other.end.y);
+  }
+  int d1 = orientationSign(t.begin, t.end, s.begin);
+  int d2 = orientationSign(t.begin, t.end, s.end);
+  int d3 = orientationSign(s.begin, s.end, t.begin);
+  int d4 = orientationSign(s.begin, s.end, t.end);
+
+  if (d1 == 0 && d2 == 0) {
+    // Collinear: the overlap of the two lexicographic ranges.
+    const Point& s_first = lexLess(s.end, s.begin) ? s.end : s.begin;
+    const Point& s_last = lexLess(s.end, s.begin) ? s.begin : s.end;
+    const Point& t_first = lexLess(t.end, t.begin) ? t.end : t.begin;
+    const Point& t_last = lexLess(t.end, t.begin) ? t.begin : t.end;
+    const Point& last_begin = lexLess(s_first, t_first) ? t_first : s_first;
+    const Point& first_end = lexLess(s_last, t_last) ? s_last : t_last;
+    if (lexLess(first_end, last_begin)) {
+      return false;
+    }
+    point = last_begin;
+    return true;
+  }
+  if (d1 * d2 > 0 || d3 * d4 > 0) {
+    return false;
+  }
+  if (d1 == 0) {
+    point = s.begin;
+  } else if (d2 == 0) {
+    point = s.end;
+  } else if (d3 == 0) {
+    point = t.begin;
+  } else if (d4 == 0) {
+    point = t.end;
+  } else {
+    point = crossingPoint(s, t).point;
+  }
+  return true;
+}
+
+}  // namespace detail
+
+/*
+ * Bentley-Ottmann sweep from left to right over lexicographically ordered
+ * event points. The status structure keeps the segments crossing the sweep
+ * line ordered by height just to the right of the current event; only
+ * neighbours in that order are ever tested, giving O((n + k) log n).
+ *
+ * Event points are exact, crossings included, and every comparison against
+ * them is exact, so the status order is always the true one: each pair of
+ * segments that meet is reported, and segments meeting at a point that is not
+ * a double are reported once there. Only the reported coordinates are
+ * rounded. Collinear overlaps are reported at every event point they share.
+ */
+class SegmentSweep {
+  struct PointLess {
+    bool operator()(const detail::SweepPoint& a, const detail::SweepPoint& b) const {
+      return detail::lexLess(a, b);
+    }
+  };
+
+  struct StatusLess {
+    const SegmentSweep* sweep;
+
+    bool operator()(size_t a, size_t b) const {
+      return sweep->less(a, b);
+    }
+  };
+
+  using Status = std::set<size_t, StatusLess>;
+
+  std::vector<Segment> segments_;
+  size_t probe_;
+  // Segments starting at each event point; crossings start none.
+  std::map<detail::SweepPoint, std::vector<size_t>, PointLess> events_;
+  Status status_;
+  std::vector<Status::iterator> position_;
+  std::vector<char> through_event_;
+  detail::SweepPoint sweep_;
+
+  bool throughEvent(size_t id) const {
+    return id == probe_ || through_event_[id] != 0;
+  }
+
+  // Exact side of the event point a segment of the status passes: -1 below,
+  // 1 above, 0 through it.
+  int side(size_t id) const {
+    return -detail::orientationSign(segments_[id].begin, segments_[id].end, sweep_);
+  }
+
+  // Positive if b turns counterclockwise from a, i.e. lies above it past a
+  // common point.
+  int turn(size_t a, size_t b) const {
+    return detail::directionTurn(segments_[a], segments_[b]);
+  }
+
+  bool less(size_t a, size_t b) const;
+
+  bool endsAfterEvent(size_t id) const {
+    // A crossing never coincides with an endpoint: that point is already an
+    // event, and the crossing merges into it.
+    return !sweep_.endpoint || detail::lexLess(sweep_.point, segments_[id].end);
+  }
+
+  template <typename Filter>
+  void checkPair(size_t lower, size_t upper, Filter filter, bool& found);
+
+  template <typename Filter>
+  bool processEvent(const std::vector<size_t>& starting, bool stop_at_first, Filter filter,
+                    std::vector<SegmentIntersection>& result);
+
+public:
+  explicit SegmentSweep(const std::vector<Segment>& segments);
+
+  SegmentSweep(const SegmentSweep&) = delete;
+  SegmentSweep& operator=(const SegmentSweep&) = delete;
+
+  // Runs the sweep. filter(i, j) decides whether segments i and j meeting is
+  // an intersection worth reporting; with stop_at_first the sweep ends at the
+  // first such pair (Shamos-Hoey style detection).
+  template <typename Filter>
+  std::vector<SegmentIntersection> run(bool stop_at_first, Filter filter);
+};
+
+SegmentSweep::SegmentSweep(const std::vector<Segment>& segments)
+    : segments_(segments), probe_(segments.size()), events_(), status_(StatusLess{this}),
+      position_(segments.size(), status_.end()), through_event_(segments.size(), 0), sweep_(Point()) {
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    Segment& segment = segments_[i];
+    if (detail::lexLess(segment.end, segment.begin)) {
+      std::swap(segment.begin, segment.end);
+    }
+    events_[detail::SweepPoint(segment.begin)].push_back(i);
+    events_[detail::SweepPoint(segment.end)];
+  }
+}
+
+bool SegmentSweep::less(size_t a, size_t b) const {
+  if (a == b) {
+    return false;
+  }
+  // The status is only ever searched with, or inserted into, segments through
+  // the event point, so one side of each comparison passes it and the other is
+  // placed by an exact side test. Segments of the status through the point
+  // sort after the probe, which thus finds the first of them.
+  int position_a = throughEvent(a) ? 0 : side(a);
+  int position_b = throughEvent(b) ? 0 : side(b);
+  if (position_a != position_b) {
+    return position_a < position_b;
+  }
+  if (a == probe_) {
+    return true;
+  }
+  if (b == probe_) {
+    return false;
+  }
+  // Through the same point: the one turning counterclockwise lies above
+  // to the right of the sweep line. Vertical segments point up and so end up
+  // above all others.
+  int direction = turn(a, b);
+  if (direction != 0) {
+    return direction > 0;
+  }
+  return a < b;
+}
+
+template <typename Filter>
+void SegmentSweep::checkPair(size_t lower, size_t upper, Filter filter, bool& found) {
+  const Segment& first = segments_[lower];
+  const Segment& second = segments_[upper];
+  // Touching at an endpoint and collinear overlaps start at an event point
+  // already, where the status search finds both segments; only a proper
+  // crossing needs an event of its own.
+  if (detail::properlyCross(first, second)) {
+    detail::SweepPoint crossing = detail::crossingPoint(first, second);
+    if (detail::lexLess(sweep_, crossing)) {
+      events_.try_emplace(std::move(crossing));
+    }
+    found = found || filter(lower, upper);
+    return;
+  }
+  Point point;
+  if (!found && filter(lower, upper) && detail::segmentsIntersect(first, second, point)) {
+    found = true;
+  }
+}
+
+template <typename Filter>
+bool SegmentSweep::processEvent(const std::vector<size_t>& starting, bool stop_at_first, Filter filter,
+                                std::vector<SegmentIntersection>& result) {
+  // Every segment of the status through this point lies in one run next to
+  // the probe.
+  std::vector<size_t> group = starting;
+  auto first = status_.lower_bound(probe_);
+  auto last = first;
+  while (last != status_.end() && side(*last) == 0) {
+    group.push_back(*last);
+    ++last;
+  }
+  std::sort(group.begin(), group.end());
+
+  if (group.size() >= 2) {
+    bool reported = false;
+    for (size_t i = 0; i < group.size() && !reported; ++i) {
+      for (size_t j = i + 1; j < group.size() && !reported; ++j) {
+        reported = filter(group[i], group[j]);
+      }
+    }
+    if (reported) {
+      result.push_back({sweep_.point, group});
+      if (stop_at_first) {
+        return true;
+      }
+    }
+  }
+
+  status_.erase(first, last);
+
+  std::vector<size_t> inserted;
+  for (size_t id : group) {
+    if (endsAfterEvent(id)) {
+      inserted.push_back(id);
+      through_event_[id] = 1;
+    }
+  }
+
+  bool found = false;
+  if (inserted.empty()) {
+    auto upper = status_.lower_bound(probe_);
+    if (upper != status_.end() && upper != status_.begin()) {
+      checkPair(*std::prev(upper), *upper, filter, found);
+    }
+  } else {
+    std::sort(inserted.begin(), inserted.end(), [this](size_t a, size_t b) { return less(a, b); });
+    for (size_t id : inserted) {
+      position_[id] = status_.insert(id).first;
+    }
+    auto lowest = position_[inserted.front()];
+    auto highest = position_[inserted.back()];
+    if (lowest != status_.begin()) {
+      checkPair(*std::prev(lowest), *lowest, filter, found);
+    }
+    auto above = std::next(highest);
+    if (above != status_.end()) {
+      checkPair(*highest, *above, filter, found);
+    }
+  }
+
+  for (size_t id : inserted) {
+    through_event_[id] = 0;
+  }
+  return stop_at_first && found;
+}
+
+template <typename Filter>
+std::vector<SegmentIntersection> SegmentSweep::run(bool stop_at_first, Filter filter) {
+  std::vector<SegmentIntersection> result;
+  while (!events_.empty()) {
+    auto event = events_.extract(events_.begin());
+    sweep_ = std::move(event.key());
+    if (processEvent(event.mapped(), stop_at_first, filter, result)) {
+      if (result.empty()) {
+        result.push_back({sweep_.point, {}});
+      }
+      break;
+    }
+  }
+  return result;
+}
+
+// All intersection points of the segments with the segments through each.
+std::vector<SegmentIntersection> findIntersections(const std::vector<Segment>& segments) {
+  SegmentSweep sweep(segments);
+  return sweep.run(false, [](size_t, size_t) { return true; });
+}
+
+// Whether any two segments share a point, without enumerating them all.
+bool hasIntersection(const std::vector<Segment>& segments) {
+  SegmentSweep sweep(segments);
+  return !sweep.run(true, [](size_t, size_t) { return true; }).empty();
+}
+
+// Whether the boundary of the polygon crosses or touches itself anywhere
+// other than where consecutive edges meet. Run this before trusting area().
+bool isSelfIntersecting(const Polygon& polygon) {
+  std::vector<Point> vertices = polygon.getVertices();
+  size_t n = vertices.size();
+  if (n < 3) {
+    return false;
+  }
+  std::vector<Segment> edges;
+  edges.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    edges.emplace_back(vertices[i], vertices[(i + 1) % n]);
+  }
+
+  // Consecutive edges may only share their common vertex: that is the case
+  // unless they are collinear and fold back onto each other.
+  auto filter = [&edges, n](size_t i, size_t j) {
+    if (j < i) {
+      std::swap(i, j);
+    }
+    bool adjacent = j == i + 1 || (i == 0 && j == n - 1);
+    if (!adjacent) {
+      return true;
+    }
+    size_t first = (i == 0 && j == n - 1) ? j : i;
+    size_t second = first == j ? i : j;
+    const Point& a = edges[first].begin;
+    const Point& b = edges[first].end;
+    const Point& c = edges[second].end;
+    return detail::orientationSign(a, b, c) == 0
+           && (c.x - b.x) * (a.x - b.x) + (c.y - b.y) * (a.y - b.y) > 0;
+  };
+  SegmentSweep sweep(edges);
+  return !sweep.run(true, filter).empty();
+}
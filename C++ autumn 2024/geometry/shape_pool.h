@@ -0,0 +1,391 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <variant>
+#include <vector>
+
+#include "geometry.h"
+
+/*
+ * Value-semantic shape storage. Polygons of any kind (Triangle, Rectangle,
+ * Square) are flattened into one vertex array, ellipses and circles live in
+ * their own dense arrays, so every batched operation below is a plain loop
+ * over contiguous memory without a single virtual call.
+ */
+using ShapeValue = std::variant<Polygon, Ellipse, Circle>;
+
+class ShapePool {
+public:
+  enum class Kind { kPolygon, kEllipse, kCircle };
+
+private:
+  struct Handle {
+    Kind kind;
+    size_t index;
+  };
+
+  struct EllipseRecord {
+    Point focus1;
+    Point focus2;
+    double sum_distances;
+  };
+
+  struct CircleRecord {
+    Point center;
+    double radius;
+  };
+
+  std::vector<Point> polygon_vertices_;
+  std::vector<size_t> polygon_offsets_;
+  std::vector<EllipseRecord> ellipses_;
+  std::vector<CircleRecord> circles_;
+  std::vector<Handle> handles_;
+
+  static double ellipseMinorSquared(const EllipseRecord& ellipse) {
+    double a = ellipse.sum_distances / 2;
+    double dx = ellipse.focus2.x - ellipse.focus1.x;
+    double dy = ellipse.focus2.y - ellipse.focus1.y;
+    return a * a - (dx * dx + dy * dy) / 4;
+  }
+
+  template <typename Function>
+  void forEachPoint(Function function) {
+    for (Point& point : polygon_vertices_) {
+      function(point);
+    }
+    for (EllipseRecord& ellipse : ellipses_) {
+      function(ellipse.focus1);
+      function(ellipse.focus2);
+    }
+    for (CircleRecord& circle : circles_) {
+      function(circle.center);
+    }
+  }
+
+  template <typename PolygonMetric, typename EllipseMetric, typename CircleMetric>
+  std::vector<double> collect(PolygonMetric polygon_metric, EllipseMetric ellipse_metric,
+                              CircleMetric circle_metric) const;
+
+public:
+  ShapePool() : polygon_vertices_(), polygon_offsets_(1, 0), ellipses_(), circles_(), handles_() {}
+
+  void reserve(size_t polygons, size_t vertices, size_t ellipses, size_t circles) {
+    polygon_offsets_.reserve(polygons + 1);
+    polygon_vertices_.reserve(vertices);
+    ellipses_.reserve(ellipses);
+    circles_.reserve(circles);
+    handles_.reserve(polygons + ellipses + circles);
+  }
+
+  size_t add(const Polygon& polygon);
+
+  size_t add(const Ellipse& ellipse);
+
+  size_t add(const Circle& circle);
+
+  size_t add(const ShapeValue& shape) {
+    return std::visit([this](const auto& concrete) { return add(concrete); }, shape);
+  }
+
+  size_t size() const {
+    return handles_.size();
+  }
+
+  bool empty() const {
+    return handles_.empty();
+  }
+
+  Kind kind(size_t index) const {
+    return handles_[index].kind;
+  }
+
+  ShapeValue get(size_t index) const;
+
+  void clear();
+
+  double polygonArea(size_t polygon) const;
+
+  double polygonPerimeter(size_t polygon) const;
+
+  BoundingBox polygonBoundingBox(size_t polygon) const;
+
+  double totalArea() const;
+
+  double totalPerimeter() const;
+
+  std::vector<double> areas() const;
+
+  std::vector<double> perimeters() const;
+
+  std::vector<BoundingBox> boundingBoxes() const;
+
+  BoundingBox boundingBox() const;
+
+  void rotate(const Point& center, double angle);
+
+  void reflect(const Point& center);
+
+  void reflect(const Line& axis);
+
+  void scale(const Point& center, double coefficient);
+};
+
+size_t ShapePool::add(const Polygon& polygon) {
+  std::vector<Point> vertices = polygon.getVertices();
+  polygon_vertices_.insert(polygon_vertices_.end(), vertices.begin(), vertices.end());
+  polygon_offsets_.push_back(polygon_vertices_.size());
+  handles_.push_back({Kind::kPolygon, polygon_offsets_.size() - 2});
+  return handles_.size() - 1;
+}
+
+size_t ShapePool::add(const Ellipse& ellipse) {
+  ellipses_.push_back({ellipse.getFocus1(), ellipse.getFocus2(), ellipse.getSumDistances()});
+  handles_.push_back({Kind::kEllipse, ellipses_.size() - 1});
+  return handles_.size() - 1;
+}
+
+size_t ShapePool::add(const Circle& circle) {
+  circles_.push_back({circle.getFocus1(), circle.radius()});
+  handles_.push_back({Kind::kCircle, circles_.size() - 1});
+  return handles_.size() - 1;
+}
+
+ShapeValue ShapePool::get(size_t index) const {
+  const Handle& handle = handles_[index];
+  switch (handle.kind) {
+    case Kind::kPolygon: {
+      auto begin = polygon_vertices_.begin() + static_cast<std::ptrdiff_t>(polygon_offsets_[handle.index]);
+      auto end = polygon_vertices_.begin() + static_cast<std::ptrdiff_t>(polygon_offsets_[handle.index + 1]);
+      return Polygon(std::vector<Point>(begin, end));
+    }
+    case Kind::kEllipse: {
+      const EllipseRecord& ellipse = ellipses_[handle.index];
+      return Ellipse(ellipse.focus1, ellipse.focus2, ellipse.sum_distances);
+    }
+    case Kind::kCircle:
+    default:
+      return Circle(circles_[handle.index].center, circles_[handle.index].radius);
+  }
+}
+
+void ShapePool::clear() {
+  polygon_vertices_.clear();
+  polygon_offsets_.assign(1, 0);
+  ellipses_.clear();
+  circles_.clear();
+  handles_.clear();
+}
+
+double ShapePool::polygonArea(size_t polygon) const {
+  size_t begin = polygon_offsets_[polygon];
+  size_t end = polygon_offsets_[polygon + 1];
+  if (begin == end) {
+    return 0.0;
+  }
+  const Point* vertices = polygon_vertices_.data();
+  double result = vertices[end - 1].x * vertices[begin].y - vertices[begin].x * vertices[end - 1].y;
+  for (size_t i = begin; i + 1 < end; ++i) {
+    result += vertices[i].x * vertices[i + 1].y - vertices[i + 1].x * vertices[i].y;
+  }
+  return 0.5 * std::abs(result);
+}
+
+double ShapePool::polygonPerimeter(size_t polygon) const {
+  size_t begin = polygon_offsets_[polygon];
+  size_t end = polygon_offsets_[polygon + 1];
+  if (begin == end) {
+    return 0.0;
+  }
+  const Point* vertices = polygon_vertices_.data();
+  double dx = vertices[begin].x - vertices[end - 1].x;
+  double dy = vertices[begin].y - vertices[end - 1].y;
+  double result = std::sqrt(dx * dx + dy * dy);
+  for (size_t i = begin; i + 1 < end; ++i) {
+    dx = vertices[i + 1].x - vertices[i].x;
+    dy = vertices[i + 1].y - vertices[i].y;
+    result += std::sqrt(dx * dx + dy * dy);
+  }
+  return result;
+}
+
+BoundingBox ShapePool::polygonBoundingBox(size_t polygon) const {
+  size_t begin = polygon_offsets_[polygon];
+  size_t end = polygon_offsets_[polygon + 1];
+  if (begin == end) {
+    return BoundingBox();
+  }
+  BoundingBox box(polygon_vertices_[begin], polygon_vertices_[begin]);
+  for (size_t i = begin + 1; i < end; ++i) {
+    box.expand(polygon_vertices_[i]);
+  }
+  return box;
+}
+
+namespace detail {
+
+// Ellipse metrics written over the flat record so they inline into the batch loops.
+inline double ellipseArea(double a, double b_squared) {
+  return M_PI * a * std::sqrt(b_squared);
+}
+
+inline double ellipsePerimeter(double a, double b_squared) {
+  double b = std::sqrt(b_squared);
+  return M_PI * (3 * (a + b) - std::sqrt((3 * a + b) * (a + 3 * b)));
+}
+
+}  // namespace detail
+
+double ShapePool::totalArea() const {
+  double result = 0.0;
+  for (size_t i = 0; i + 1 < polygon_offsets_.size(); ++i) {
+    result += polygonArea(i);
+  }
+  for (const EllipseRecord& ellipse : ellipses_) {
+    result += detail::ellipseArea(ellipse.sum_distances / 2, ellipseMinorSquared(ellipse));
+  }
+  for (const CircleRecord& circle : circles_) {
+    result += M_PI * circle.radius * circle.radius;
+  }
+  return result;
+}
+
+double ShapePool::totalPerimeter() const {
+  double result = 0.0;
+  for (size_t i = 0; i + 1 < polygon_offsets_.size(); ++i) {
+    result += polygonPerimeter(i);
+  }
+  for (const EllipseRecord& ellipse : ellipses_) {
+    result += detail::ellipsePerimeter(ellipse.sum_distances / 2, ellipseMinorSquared(ellipse));
+  }
+  for (const CircleRecord& circle : circles_) {
+    result += 2 * M_PI * circle.radius;
+  }
+  return result;
+}
+
+template <typename PolygonMetric, typename EllipseMetric, typename CircleMetric>
+std::vector<double> ShapePool::collect(PolygonMetric polygon_metric, EllipseMetric ellipse_metric,
+                                       CircleMetric circle_metric) const {
+  std::vector<double> by_polygon(polygon_offsets_.size() - 1);
+  for (size_t i = 0; i < by_polygon.size(); ++i) {
+    by_polygon[i] = polygon_metric(i);
+  }
+  std::vector<double> by_ellipse(ellipses_.size());
+  for (size_t i = 0; i < by_ellipse.size(); ++i) {
+    by_ellipse[i] = ellipse_metric(ellipses_[i]);
+  }
+  std::vector<double> by_circle(circles_.size());
+  for (size_t i = 0; i < by_circle.size(); ++i) {
+    by_circle[i] = circle_metric(circles_[i]);
+  }
+
+  const std::vector<double>* by_kind[] = {&by_polygon, &by_ellipse, &by_circle};
+  std::vector<double> result(handles_.size());
+  for (size_t i = 0; i < handles_.size(); ++i) {
+    result[i] = (*by_kind[static_cast<size_t>(handles_[i].kind)])[handles_[i].index];
+  }
+  return result;
+}
+
+std::vector<double> ShapePool::areas() const {
+  return collect(
+      [this](size_t polygon) { return polygonArea(polygon); },
+      [](const EllipseRecord& ellipse) {
+        return detail::ellipseArea(ellipse.sum_distances / 2, ellipseMinorSquared(ellipse));
+      },
+      [](const CircleRecord& circle) { return M_PI * circle.radius * circle.radius; });
+}
+
+std::vector<double> ShapePool::perimeters() const {
+  return collect(
+      [this](size_t polygon) { return polygonPerimeter(polygon); },
+      [](const EllipseRecord& ellipse) {
+        return detail::ellipsePerimeter(ellipse.sum_distances / 2, ellipseMinorSquared(ellipse));
+      },
+      [](const CircleRecord& circle) { return 2 * M_PI * circle.radius; });
+}
+
+std::vector<BoundingBox> ShapePool::boundingBoxes() const {
+  std::vector<BoundingBox> result(handles_.size());
+  for (size_t i = 0; i < handles_.size(); ++i) {
+    const Handle& handle = handles_[i];
+    if (handle.kind == Kind::kPolygon) {
+      result[i] = polygonBoundingBox(handle.index);
+    } else if (handle.kind == Kind::kEllipse) {
+      // Half extents of a rotated ellipse: sqrt(b^2 + (df / 2)^2) along each axis,
+      // where df is the focal vector projected onto that axis.
+      const EllipseRecord& ellipse = ellipses_[handle.index];
+      double b_squared = ellipseMinorSquared(ellipse);
+      double dx = (ellipse.focus2.x - ellipse.focus1.x) / 2;
+      double dy = (ellipse.focus2.y - ellipse.focus1.y) / 2;
+      double half_width = std::sqrt(b_squared + dx * dx);
+      double half_height = std::sqrt(b_squared + dy * dy);
+      Point center((ellipse.focus1.x + ellipse.focus2.x) / 2, (ellipse.focus1.y + ellipse.focus2.y) / 2);
+      result[i] = BoundingBox(Point(center.x - half_width, center.y - half_height),
+                              Point(center.x + half_width, center.y + half_height));
+    } else {
+      const CircleRecord& circle = circles_[handle.index];
+      result[i] = BoundingBox(Point(circle.center.x - circle.radius, circle.center.y - circle.radius),
+                              Point(circle.center.x + circle.radius, circle.center.y + circle.radius));
+    }
+  }
+  return result;
+}
+
+BoundingBox ShapePool::boundingBox() const {
+  std::vector<BoundingBox> boxes = boundingBoxes();
+  if (boxes.empty()) {
+    return BoundingBox();
+  }
+  BoundingBox result = boxes[0];
+  for (const BoundingBox& box : boxes) {
+    result.expand(box.min);
+    result.expand(box.max);
+  }
+  return result;
+}
+
+void ShapePool::rotate(const Point& center, double angle) {
+  angle = (angle * M_PI) / 180.0;
+  double cos_angle = std::cos(angle);
+  double sin_angle = std::sin(angle);
+  forEachPoint([&center, cos_angle, sin_angle](Point& point) {
+    double dx = point.x - center.x;
+    double dy = point.y - center.y;
+    point.x = dx * cos_angle - dy * sin_angle + center.x;
+    point.y = dx * sin_angle + dy * cos_angle + center.y;
+  });
+}
+
+void ShapePool::reflect(const Point& center) {
+  forEachPoint([&center](Point& point) {
+    point.x = 2 * center.x - point.x;
+    point.y = 2 * center.y - point.y;
+  });
+}
+
+void ShapePool::reflect(const Line& axis) {
+  double a = axis.getA();
+  double b = axis.getB();
+  double c = axis.getC();
+  double norm = a * a + b * b;
+  forEachPoint([a, b, c, norm](Point& point) {
+    double shift = 2 * (a * point.x + b * point.y + c) / norm;
+    point.x -= shift * a;
+    point.y -= shift * b;
+  });
+}
+
+void ShapePool::scale(const Point& center, double coefficient) {
+  forEachPoint([&center, coefficient](Point& point) {
+    point.x = coefficient * (point.x - center.x) + center.x;
+    point.y = coefficient * (point.y - center.y) + center.y;
+  });
+  for (EllipseRecord& ellipse : ellipses_) {
+    ellipse.sum_distances *= std::abs(coefficient);
+  }
+  for (CircleRecord& circle : circles_) {
+    circle.radius *= std::abs(coefficient);
+  }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdlib>
+#include <cstring>
+
+// Stack of words in two growable arrays: the words themselves, each followed
+// by '\0', back to back in bytes, and the offset of every word in offsets.
+// A resize moves each array once with realloc instead of copying word by
+// word, and both grow and shrink geometrically, so push and pop are
+// amortized O(1) plus the length of the word. clear frees the two arrays and
+// does not look at the words at all.
+
+const size_t arena_min_capacity = 16;
+
+// New capacity for an array holding used elements out of capacity, or
+// capacity itself when it fits: doubled until used fits, halved while used
+// takes at most a quarter of it.
+size_t arena_fit_capacity(size_t used, size_t capacity) {
+  if (capacity < arena_min_capacity) {
+    capacity = arena_min_capacity;
+  }
+  while (used > capacity) {
+    capacity *= 2;
+  }
+  while (capacity > arena_min_capacity && used <= capacity / 4) {
+    capacity /= 2;
+  }
+  return capacity;
+}
+
+void arena_fit_bytes(char*& bytes, size_t bytes_used, size_t& bytes_cap) {
+  size_t new_cap = arena_fit_capacity(bytes_used, bytes_cap);
+  if (bytes == nullptr || new_cap != bytes_cap) {
+    bytes = (char*) realloc(bytes, new_cap);
+    bytes_cap = new_cap;
+  }
+}
+
+void arena_fit_offsets(size_t*& offsets, size_t count, size_t& offsets_cap) {
+  size_t new_cap = arena_fit_capacity(count, offsets_cap);
+  if (offsets == nullptr || new_cap != offsets_cap) {
+    offsets = (size_t*) realloc(offsets, new_cap * sizeof(size_t));
+    offsets_cap = new_cap;
+  }
+}
+
+void arena_push(char*& bytes, size_t& bytes_used, size_t& bytes_cap, size_t*& offsets, size_t& count,
+                size_t& offsets_cap, const char* word, size_t length) {
+  arena_fit_bytes(bytes, bytes_used + length + 1, bytes_cap);
+  arena_fit_offsets(offsets, count + 1, offsets_cap);
+  memcpy(bytes + bytes_used, word, length);
+  bytes[bytes_used + length] = '\0';
+  offsets[count] = bytes_used;
+  bytes_used += length + 1;
+  count++;
+}
+
+// The top word, valid until the next push, pop or clear; count must be
+// positive.
+const char* arena_back(const char* bytes, const size_t* offsets, size_t count) {
+  return bytes + offsets[count - 1];
+}
+
+void arena_pop(char*& bytes, size_t& bytes_used, size_t& bytes_cap, size_t*& offsets, size_t& count,
+               size_t& offsets_cap) {
+  count--;
+  bytes_used = offsets[count];
+  arena_fit_bytes(bytes, bytes_used, bytes_cap);
+  arena_fit_offsets(offsets, count, offsets_cap);
+}
+
+void arena_clear(char*& bytes, size_t& bytes_used, size_t& bytes_cap, size_t*& offsets, size_t& count,
+                 size_t& offsets_cap) {
+  free(bytes);
+  free(offsets);
+  bytes = nullptr;
+  offsets = nullptr;
+  bytes_used = 0;
+  bytes_cap = 0;
+  count = 0;
+  offsets_cap = 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * Command stream generator for the stack protocol:
+ * make generator && ./generator [options] > trace.txt
+ *
+ *   --commands=N           commands before the final exit, 10^6 by default
+ *   --seed=N               seed of the stream, 2024 by default
+ *   --mix=PUSH:POP:BACK:SIZE
+ *                          relative weights of the commands, 50:30:10:10 by
+ *                          default
+ *   --word-min=N           shortest word, 1 by default
+ *   --word-max=N           longest word, 16 by default
+ *   --word-distribution=uniform|geometric
+ *                          word lengths uniform in [min, max], or min plus a
+ *                          geometric tail with mean (max - min) / 4 + 1, cut
+ *                          at max; uniform by default
+ *   --clear-every=N        a clear once per N commands on average, never by
+ *                          default
+ *
+ * Every random choice is derived here from the raw mt19937_64 output, which
+ * the standard fixes, so a seed gives the same trace with any standard
+ * library. Words are letters and digits, as the protocol allows.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace {
+
+struct Options {
+  size_t commands = 1000000;
+  unsigned long long seed = 2024;
+  uint64_t weights[4] = {50, 30, 10, 10};
+  size_t word_min = 1;
+  size_t word_max = 16;
+  bool geometric = false;
+  uint64_t clear_every = 0;
+};
+
+const char kAlphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+class Generator {
+  Options options_;
+  std::mt19937_64 random_;
+  std::string out_;
+
+  // Uniform in [0, bound); the modulo bias is below 2^-40 for the bounds
+  // used here.
+  uint64_t below(uint64_t bound) {
+    return random_() % bound;
+  }
+
+  size_t wordLength() {
+    size_t span = options_.word_max - options_.word_min;
+    if (!options_.geometric) {
+      return options_.word_min + below(span + 1);
+    }
+    // Each extra char with probability q = mean / (mean + 1).
+    size_t mean = span / 4 + 1;
+    size_t length = options_.word_min;
+    while (length < options_.word_max && below(mean + 1) < mean) {
+      ++length;
+    }
+    return length;
+  }
+
+  void flush() {
+    std::fwrite(out_.data(), 1, out_.size(), stdout);
+    out_.clear();
+  }
+
+public:
+  explicit Generator(const Options& options) : options_(options), random_(options.seed), out_() {
+    out_.reserve(1 << 20);
+  }
+
+  void run() {
+    static const char* const kCommands[] = {"push ", "pop", "back", "size"};
+    uint64_t total_weight = 0;
+    for (uint64_t weight : options_.weights) {
+      total_weight += weight;
+    }
+    for (size_t i = 0; i < options_.commands; ++i) {
+      if (options_.clear_every > 0 && below(options_.clear_every) == 0) {
+        out_ += "clear\n";
+      } else {
+        uint64_t pick = below(total_weight);
+        size_t command = 0;
+        while (pick >= options_.weights[command]) {
+          pick -= options_.weights[command];
+          ++command;
+        }
+        out_ += kCommands[command];
+        if (command == 0) {
+          for (size_t length = wordLength(); length > 0; --length) {
+            out_ += kAlphabet[below(sizeof(kAlphabet) - 1)];
+          }
+        }
+        out_ += '\n';
+      }
+      if (out_.size() >= (1 << 20) - 64) {
+        flush();
+      }
+    }
+    out_ += "exit\n";
+    flush();
+  }
+};
+
+void parseMix(const char* text, Options& options) {
+  char* end = nullptr;
+  for (size_t i = 0; i < 4; ++i) {
+    options.weights[i] = std::strtoull(text, &end, 10);
+    if (i < 3) {
+      if (*end != ':') {
+        std::fprintf(stderr, "--mix wants four weights, as in 50:30:10:10\n");
+        std::exit(1);
+      }
+      text = end + 1;
+    }
+  }
+  if (options.weights[0] + options.weights[1] + options.weights[2] + options.weights[3] == 0) {
+    std::fprintf(stderr, "--mix wants a positive weight\n");
+    std::exit(1);
+  }
+}
+
+Options parseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const char* argument = argv[i];
+    if (std::strncmp(argument, "--commands=", 11) == 0) {
+      options.commands = std::strtoull(argument + 11, nullptr, 10);
+    } else if (std::strncmp(argument, "--seed=", 7) == 0) {
+      options.seed = std::strtoull(argument + 7, nullptr, 10);
+    } else if (std::strncmp(argument, "--mix=", 6) == 0) {
+      parseMix(argument + 6, options);
+    } else if (std::strncmp(argument, "--word-min=", 11) == 0) {
+      options.word_min = std::strtoull(argument + 11, nullptr, 10);
+    } else if (std::strncmp(argument, "--word-max=", 11) == 0) {
+      options.word_max = std::strtoull(argument + 11, nullptr, 10);
+    } else if (std::strcmp(argument, "--word-distribution=uniform") == 0) {
+      options.geometric = false;
+    } else if (std::strcmp(argument, "--word-distribution=geometric") == 0) {
+      options.geometric = true;
+    } else if (std::strncmp(argument, "--clear-every=", 14) == 0) {
+      options.clear_every = std::strtoull(argument + 14, nullptr, 10);
+    } else {
+      std::fprintf(stderr, "unknown option %s\n", argument);
+      std::exit(1);
+    }
+  }
+  if (options.word_min == 0 || options.word_min > options.word_max) {
+    std::fprintf(stderr, "word lengths need 1 <= --word-min <= --word-max\n");
+    std::exit(1);
+  }
+  return options;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Generator generator(parseOptions(argc, argv));
+  generator.run();
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdlib>
+#include <cstring>
+
+// The original engine of stack.cpp, kept as the baseline for replay: every
+// word has its own calloc'ed copy, and a resize of the pointer array
+// allocates and copies every stored word again.
+
+const int legacy_default_capacity = 2;
+
+void legacy_init(char**& stack, int& stack_size, int& stack_cap) {
+  stack = (char**) calloc(legacy_default_capacity, sizeof(char*));
+  stack_size = 0;
+  stack_cap = legacy_default_capacity;
+}
+
+void legacy_push(char**& stack, int& stack_size, int& stack_cap, const char* str) {
+  while (stack_size > stack_cap - 1) {
+    stack_cap *= 2;
+    char** temp = (char**) calloc(stack_cap, sizeof(char*));
+    for (int i = 0; i < stack_size; i++) {
+      temp[i] = (char*) calloc(strlen(stack[i]) + 1, sizeof(char));
+      strncpy(temp[i], stack[i], strlen(stack[i]));
+      free(stack[i]);
+    }
+    free(stack);
+    stack = temp;
+  }
+  stack[stack_size] = (char*) calloc(strlen(str) + 1, sizeof(char));
+  strcpy(stack[stack_size], str);
+  stack_size++;
+}
+
+// stack_size must be positive.
+void legacy_pop(char**& stack, int& stack_size, int& stack_cap) {
+  stack_size--;
+  free(stack[stack_size]);
+  if (stack_cap >= 4 * stack_size && stack_cap > 1) {
+    stack_cap /= 2;
+    char** temp = (char**) calloc(stack_cap, sizeof(char*));
+    for (int i = 0; i < stack_size; i++) {
+      temp[i] = (char*) calloc(strlen(stack[i]) + 1, sizeof(char));
+      strcpy(temp[i], stack[i]);
+      free(stack[i]);
+    }
+    free(stack);
+    stack = temp;
+  }
+}
+
+void legacy_clear(char**& stack, int& stack_size, int& stack_cap) {
+  for (int i = 0; i < stack_size; i++) {
+    free(stack[i]);
+  }
+  stack_size = 0;
+  stack_cap = legacy_default_capacity;
+}
+
+void legacy_free(char**& stack, int& stack_size, int& stack_cap) {
+  legacy_clear(stack, stack_size, stack_cap);
+  free(stack);
+  stack = nullptr;
+}
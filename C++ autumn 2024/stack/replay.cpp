@@ -0,0 +1,382 @@
+/*
+ * Replay driver for the stack protocol:
+ * make replay && ./replay TRACE [engine...]
+ *
+ * Runs a trace, as written by the generator, through every named engine
+ * (legacy, arena and stack by default) and prints one CSV row per engine:
+ * commands per second, heap allocation calls and the peak of live heap
+ * bytes while replaying, and the peak RSS of the process.
+ *
+ * The trace is loaded into memory first and responses go to an in-memory
+ * sink, so the numbers cover parsing, the engine and formatting but no
+ * I/O. Every engine replays in a forked child so that peak RSS is its own;
+ * the loaded trace is included in it equally for all engines, and
+ * rss_before_kb shows how much that is. The checksum of the responses must
+ * match across engines.
+ */
+
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "arena_stack.h"
+#include "legacy_stack.h"
+#include "word_stack.h"
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void __libc_free(void* pointer);
+}
+
+namespace {
+
+// Heap statistics, kept by the malloc family below; operator new goes
+// through malloc as well.
+size_t allocation_calls = 0;
+size_t live_bytes = 0;
+size_t peak_live_bytes = 0;
+
+void noteAllocation(void* pointer) {
+  if (pointer != nullptr) {
+    live_bytes += malloc_usable_size(pointer);
+    if (live_bytes > peak_live_bytes) {
+      peak_live_bytes = live_bytes;
+    }
+  }
+}
+
+}  // namespace
+
+extern "C" void* malloc(size_t size) {
+  ++allocation_calls;
+  void* pointer = __libc_malloc(size);
+  noteAllocation(pointer);
+  return pointer;
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+  ++allocation_calls;
+  void* pointer = __libc_calloc(count, size);
+  noteAllocation(pointer);
+  return pointer;
+}
+
+extern "C" void* realloc(void* pointer, size_t size) {
+  ++allocation_calls;
+  if (pointer != nullptr) {
+    live_bytes -= malloc_usable_size(pointer);
+  }
+  void* moved = __libc_realloc(pointer, size);
+  noteAllocation(moved);
+  return moved;
+}
+
+extern "C" void free(void* pointer) {
+  if (pointer != nullptr) {
+    live_bytes -= malloc_usable_size(pointer);
+  }
+  __libc_free(pointer);
+}
+
+namespace {
+
+// Lines of a trace file, newlines replaced by '\0' so every line and every
+// pushed word is a C string inside the one buffer.
+class Trace {
+  std::vector<char> text_;
+  std::vector<size_t> lines_;
+
+public:
+  explicit Trace(const char* path) : text_(), lines_() {
+    FILE* file = std::fopen(path, "rb");
+    if (file == nullptr) {
+      std::perror(path);
+      std::exit(1);
+    }
+    char block[1 << 16];
+    for (size_t got; (got = std::fread(block, 1, sizeof(block), file)) > 0;) {
+      text_.insert(text_.end(), block, block + got);
+    }
+    std::fclose(file);
+    text_.push_back('\n');
+    size_t start = 0;
+    for (size_t i = 0; i < text_.size(); ++i) {
+      if (text_[i] == '\r') {
+        text_[i] = '\0';
+      } else if (text_[i] == '\n') {
+        text_[i] = '\0';
+        lines_.push_back(start);
+        start = i + 1;
+      }
+    }
+  }
+
+  size_t size() const {
+    return lines_.size();
+  }
+
+  const char* line(size_t index) const {
+    return text_.data() + lines_[index];
+  }
+};
+
+// Collects the responses and keeps their length and FNV-1a hash.
+class Sink {
+  uint64_t bytes_;
+  uint64_t hash_;
+
+public:
+  Sink() : bytes_(0), hash_(14695981039346656037ULL) {}
+
+  void write(const char* data, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+      hash_ = (hash_ ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+    }
+    bytes_ += length;
+  }
+
+  void line(const char* text) {
+    write(text, std::strlen(text));
+    write("\n", 1);
+  }
+
+  void number(size_t value) {
+    char digits[24];
+    int length = std::snprintf(digits, sizeof(digits), "%zu\n", value);
+    write(digits, static_cast<size_t>(length));
+  }
+
+  uint64_t bytes() const {
+    return bytes_;
+  }
+
+  uint64_t hash() const {
+    return hash_;
+  }
+};
+
+class LegacyEngine {
+  char** stack_;
+  int size_;
+  int cap_;
+
+public:
+  LegacyEngine() : stack_(nullptr), size_(0), cap_(0) {
+    legacy_init(stack_, size_, cap_);
+  }
+
+  LegacyEngine(const LegacyEngine&) = delete;
+
+  LegacyEngine& operator=(const LegacyEngine&) = delete;
+
+  ~LegacyEngine() {
+    legacy_free(stack_, size_, cap_);
+  }
+
+  void push(const char* word, size_t) {
+    legacy_push(stack_, size_, cap_, word);
+  }
+
+  const char* back() const {
+    return stack_[size_ - 1];
+  }
+
+  void pop() {
+    legacy_pop(stack_, size_, cap_);
+  }
+
+  size_t size() const {
+    return static_cast<size_t>(size_);
+  }
+
+  void clear() {
+    legacy_clear(stack_, size_, cap_);
+  }
+};
+
+class ArenaEngine {
+  char* bytes_;
+  size_t bytes_used_;
+  size_t bytes_cap_;
+  size_t* offsets_;
+  size_t size_;
+  size_t offsets_cap_;
+
+public:
+  ArenaEngine() : bytes_(nullptr), bytes_used_(0), bytes_cap_(0), offsets_(nullptr), size_(0), offsets_cap_(0) {}
+
+  ArenaEngine(const ArenaEngine&) = delete;
+
+  ArenaEngine& operator=(const ArenaEngine&) = delete;
+
+  ~ArenaEngine() {
+    clear();
+  }
+
+  void push(const char* word, size_t length) {
+    arena_push(bytes_, bytes_used_, bytes_cap_, offsets_, size_, offsets_cap_, word, length);
+  }
+
+  const char* back() const {
+    return arena_back(bytes_, offsets_, size_);
+  }
+
+  void pop() {
+    arena_pop(bytes_, bytes_used_, bytes_cap_, offsets_, size_, offsets_cap_);
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  void clear() {
+    arena_clear(bytes_, bytes_used_, bytes_cap_, offsets_, size_, offsets_cap_);
+  }
+};
+
+// The engine stack.cpp runs on: words on Stack<char> and Stack<size_t>.
+class StackEngine {
+  Stack<char> bytes_;
+  Stack<size_t> offsets_;
+
+public:
+  StackEngine() : bytes_(), offsets_() {}
+
+  void push(const char* word, size_t length) {
+    push_word(bytes_, offsets_, word, length);
+  }
+
+  const char* back() const {
+    return top_word(bytes_, offsets_);
+  }
+
+  void pop() {
+    pop_word(bytes_, offsets_);
+  }
+
+  size_t size() const {
+    return offsets_.size();
+  }
+
+  void clear() {
+    clear_words(bytes_, offsets_);
+  }
+};
+
+// Same dispatch as stack.cpp: the first chars pick the command.
+template <typename Engine>
+size_t replay(const Trace& trace, Sink& sink) {
+  Engine engine;
+  size_t commands = 0;
+  for (size_t i = 0; i < trace.size(); ++i) {
+    const char* line = trace.line(i);
+    ++commands;
+    if (line[0] == 'p' && line[1] == 'u') {
+      const char* word = line + 4;
+      while (*word == ' ') {
+        ++word;
+      }
+      engine.push(word, std::strlen(word));
+      sink.write("ok\n", 3);
+    } else if (line[0] == 'p' && line[1] == 'o') {
+      if (engine.size() == 0) {
+        sink.write("error\n", 6);
+      } else {
+        sink.line(engine.back());
+        engine.pop();
+      }
+    } else if (line[0] == 'b') {
+      if (engine.size() == 0) {
+        sink.write("error\n", 6);
+      } else {
+        sink.line(engine.back());
+      }
+    } else if (line[0] == 's') {
+      sink.number(engine.size());
+    } else if (line[0] == 'c') {
+      engine.clear();
+      sink.write("ok\n", 3);
+    } else if (line[0] == 'e') {
+      sink.write("bye\n", 4);
+      break;
+    } else {
+      --commands;
+    }
+  }
+  return commands;
+}
+
+long peakRssKb() {
+  rusage usage = {};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+void run(const char* engine, const char* path) {
+  Trace trace(path);
+  Sink sink;
+  long rss_before = peakRssKb();
+  size_t calls_before = allocation_calls;
+  size_t live_before = live_bytes;
+  peak_live_bytes = live_bytes;
+  auto start = std::chrono::steady_clock::now();
+  size_t commands = 0;
+  if (std::strcmp(engine, "legacy") == 0) {
+    commands = replay<LegacyEngine>(trace, sink);
+  } else if (std::strcmp(engine, "arena") == 0) {
+    commands = replay<ArenaEngine>(trace, sink);
+  } else if (std::strcmp(engine, "stack") == 0) {
+    commands = replay<StackEngine>(trace, sink);
+  } else {
+    std::fprintf(stderr, "unknown engine %s\n", engine);
+    std::exit(1);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::printf("%s,%zu,%.6f,%.0f,%zu,%zu,%ld,%ld,%llu,%016llx\n", engine, commands, seconds,
+              static_cast<double>(commands) / seconds, allocation_calls - calls_before,
+              peak_live_bytes - live_before, rss_before, peakRssKb(),
+              static_cast<unsigned long long>(sink.bytes()), static_cast<unsigned long long>(sink.hash()));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: %s TRACE [legacy|arena|stack]...\n", argv[0]);
+    return 1;
+  }
+  std::vector<const char*> engines(argv + 2, argv + argc);
+  if (engines.empty()) {
+    engines = {"legacy", "arena", "stack"};
+  }
+  std::printf("engine,commands,seconds,commands_per_sec,allocation_calls,peak_heap_bytes,rss_before_kb,"
+              "peak_rss_kb,output_bytes,checksum\n");
+  for (const char* engine : engines) {
+    std::fflush(stdout);
+    pid_t child = fork();
+    if (child < 0) {
+      std::perror("fork");
+      return 1;
+    }
+    if (child == 0) {
+      run(engine, argv[1]);
+      std::fflush(stdout);
+      _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      return 1;
+    }
+  }
+}
@@ -1,79 +1,45 @@
+#include <cstdio>
 #include <iostream>
 #include <cstring>
 
-const ssize_t default_capacity = 2;
+#include "word_stack.h"
 
-void push(char**& stack, int& stack_size, int& stack_cap, const char* str) {
-  while (stack_size > stack_cap - 1) {
-    stack_cap *= 2;
-    char** temp = (char**) calloc(stack_cap, sizeof(char*));
-    for (int i = 0; i < stack_size; i++) {
-      temp[i] = (char*) calloc(strlen(stack[i]) + 1, sizeof(char));
-      strncpy(temp[i], stack[i], strlen(stack[i]));
-      free(stack[i]);
-    }
-    free(stack);
-    stack = temp;
-  }
-  stack[stack_size] = (char*) calloc(strlen(str) + 1, sizeof(char));
-  strcpy(stack[stack_size], str);
-  stack_size++;
+const ssize_t default_capacity = 2;
 
+void push(Stack<char>& bytes, Stack<size_t>& offsets, const char* str) {
+  push_word(bytes, offsets, str, strlen(str));
   std::cout << "ok" << std::endl;
 }
 
-void pop(char**& stack, int& stack_size, int& stack_cap) {
-  if (stack_size == 0) {
+void pop(Stack<char>& bytes, Stack<size_t>& offsets) {
+  if (offsets.empty()) {
     std::cout << "error" << std::endl;
   } else {
-    stack_size--;
-    std::cout << stack[stack_size] << std::endl;
-    free(stack[stack_size]);
-    if (stack_cap >= 4 * stack_size && stack_cap > 1) {
-      stack_cap /= 2;
-      char** temp = (char**) calloc(stack_cap, sizeof(char*));
-      for (int i = 0; i < stack_size; i++) {
-        temp[i] = (char*) calloc(strlen(stack[i]) + 1, sizeof(char));
-        strcpy(temp[i], stack[i]);
-        free(stack[i]);
-      }
-      free(stack);
-      stack = temp;
-    }
+    std::cout << top_word(bytes, offsets) << std::endl;
+    pop_word(bytes, offsets);
   }
 }
 
-void back(char**& stack, const int stack_size) {
-  if (stack_size == 0) {
+void back(const Stack<char>& bytes, const Stack<size_t>& offsets) {
+  if (offsets.empty()) {
     std::cout << "error" << std::endl;
   } else {
-    std::cout << stack[stack_size - 1] << std::endl;
+    std::cout << top_word(bytes, offsets) << std::endl;
   }
 }
 
-void size(const int stack_size) {
-  std::cout << stack_size << std::endl;
+void size(const Stack<size_t>& offsets) {
+  std::cout << offsets.size() << std::endl;
 }
 
-void clear(char**& stack, int& stack_size, int& stack_cap) {
-  for (int i = 0; i < stack_size; i++) {
-    free(stack[i]);
-  }
-  stack_size = 0;
-  stack_cap = default_capacity;
+void clear(Stack<char>& bytes, Stack<size_t>& offsets) {
+  clear_words(bytes, offsets);
   std::cout << "ok" << std::endl;
 }
 
-void exit(char**& stack, int& stack_size, int& stack_cap) {
+void exit(Stack<char>& bytes, Stack<size_t>& offsets) {
   std::cout << "bye" << std::endl;
-  if (stack != nullptr) {
-    for (int i = 0; i < stack_size; i++) {
-      free(stack[i]);
-    }
-    free(stack);
-    stack_size = 0;
-    stack_cap = default_capacity;
-  }
+  clear_words(bytes, offsets);
 }
 
 void realloc_string(char*& str, const int& str_len, int& str_cap) {
@@ -99,10 +65,138 @@ void read_string(char*& str, int& str_len, int& str_cap) {
   }
 }
 
-int main() {
-  char** stack = (char**) calloc(default_capacity, sizeof(char*));
-  int stack_size = 0;
-  int stack_cap = default_capacity;
+// Batch mode: stdin is read in blocks of block_size bytes and every complete
+// line in a block is handled in place, the words pointing into the block.
+// Responses are collected in an output buffer written once per block.
+const size_t block_size = 1 << 20;
+
+void out_flush(char* out, size_t& out_len) {
+  fwrite(out, 1, out_len, stdout);
+  out_len = 0;
+}
+
+void out_write(char* out, size_t& out_len, const char* data, size_t length) {
+  if (out_len + length > block_size) {
+    out_flush(out, out_len);
+    if (length > block_size) {
+      fwrite(data, 1, length, stdout);
+      return;
+    }
+  }
+  memcpy(out + out_len, data, length);
+  out_len += length;
+}
+
+void out_line(char* out, size_t& out_len, const char* str) {
+  out_write(out, out_len, str, strlen(str));
+  out_write(out, out_len, "\n", 1);
+}
+
+void out_number(char* out, size_t& out_len, size_t number) {
+  char digits[24];
+  size_t first = sizeof(digits);
+  digits[--first] = '\n';
+  do {
+    digits[--first] = (char) ('0' + number % 10);
+    number /= 10;
+  } while (number > 0);
+  out_write(out, out_len, digits + first, sizeof(digits) - first);
+}
+
+// Handles the command in [line, line + length); returns false after exit.
+bool run_command(const char* line, size_t length, Stack<char>& bytes, Stack<size_t>& offsets, char* out,
+                 size_t& out_len) {
+  if (length > 0 && line[length - 1] == '\r') {
+    length--;
+  }
+  if (length >= 2 && line[0] == 'p' && line[1] == 'u') {
+    size_t start = 4;
+    while (start < length && line[start] == ' ') {
+      start++;
+    }
+    size_t end = start;
+    while (end < length && line[end] != ' ') {
+      end++;
+    }
+    // A push without a word, or a line too short to hold one, gets no answer,
+    // like an unknown command. Line mode differs on purpose: there strtok
+    // returns null and the push dereferences it.
+    if (end > start) {
+      push_word(bytes, offsets, line + start, end - start);
+      out_write(out, out_len, "ok\n", 3);
+    }
+  } else if (length >= 2 && line[0] == 'p' && line[1] == 'o') {
+    if (offsets.empty()) {
+      out_write(out, out_len, "error\n", 6);
+    } else {
+      out_line(out, out_len, top_word(bytes, offsets));
+      pop_word(bytes, offsets);
+    }
+  } else if (length >= 1 && line[0] == 'b') {
+    if (offsets.empty()) {
+      out_write(out, out_len, "error\n", 6);
+    } else {
+      out_line(out, out_len, top_word(bytes, offsets));
+    }
+  } else if (length >= 1 && line[0] == 's') {
+    out_number(out, out_len, offsets.size());
+  } else if (length >= 1 && line[0] == 'c') {
+    clear_words(bytes, offsets);
+    out_write(out, out_len, "ok\n", 3);
+  } else if (length >= 1 && line[0] == 'e') {
+    out_write(out, out_len, "bye\n", 4);
+    return false;
+  }
+  return true;
+}
+
+// Runs commands until exit or the end of input. A line longer than a block
+// makes the block grow, so no line is ever cut.
+void run_batch(Stack<char>& bytes, Stack<size_t>& offsets) {
+  size_t block_cap = block_size;
+  char* block = (char*) malloc(block_cap);
+  char* out = (char*) malloc(block_size);
+  size_t out_len = 0;
+  size_t filled = 0;
+  bool running = true;
+  while (running) {
+    size_t got = fread(block + filled, 1, block_cap - filled, stdin);
+    filled += got;
+    size_t start = 0;
+    while (running && start < filled) {
+      const char* newline = (const char*) memchr(block + start, '\n', filled - start);
+      if (newline == nullptr && got > 0) {
+        break;
+      }
+      size_t length = newline == nullptr ? filled - start : (size_t) (newline - block) - start;
+      running = run_command(block + start, length, bytes, offsets, out, out_len);
+      start += length + 1;
+    }
+    out_flush(out, out_len);
+    if (got == 0) {
+      break;
+    }
+    // Keep the unfinished last line for the next block.
+    filled -= start;
+    memmove(block, block + start, filled);
+    if (filled == block_cap) {
+      block_cap *= 2;
+      block = (char*) realloc(block, block_cap);
+    }
+  }
+  fflush(stdout);
+  free(block);
+  free(out);
+  clear_words(bytes, offsets);
+}
+
+int main(int argc, char** argv) {
+  Stack<char> bytes;
+  Stack<size_t> offsets;
+  if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+    run_batch(bytes, offsets);
+    return 0;
+  }
   char* str = (char*) calloc(default_capacity, sizeof(char));
   int str_len = 0;
   int str_cap = default_capacity;
@@ -111,19 +205,17 @@ int main() {
     if (str[0] == 'p' && str[1] == 'u') {
       const char* word = strtok(str, " ");
       word = strtok(nullptr, " ");
-      char* word_copy = strdup(word);
-      push(stack, stack_size, stack_cap, word_copy);
-      free(word_copy);
+      push(bytes, offsets, word);
     } else if (str[0] == 'p' && str[1] == 'o') {
-      pop(stack, stack_size, stack_cap);
+      pop(bytes, offsets);
     } else if (str[0] == 'b') {
-      back(stack, stack_size);
+      back(bytes, offsets);
     } else if (str[0] == 's') {
-      size(stack_size);
+      size(offsets);
     } else if (str[0] == 'c') {
-      clear(stack, stack_size, stack_cap);
+      clear(bytes, offsets);
     } else if (str[0] == 'e') {
-      exit(stack, stack_size, stack_cap);
+      exit(bytes, offsets);
       free(str);
       break;
     }
@@ -0,0 +1,324 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Stack over one contiguous buffer obtained from Allocator through
+ * std::allocator_traits, so it runs on std::allocator as well as on
+ * StackAllocator from list+stackallocator. Elements only need to be
+ * movable: growing moves them with std::move_if_noexcept, so a type whose
+ * move may throw is copied instead and a failed growth leaves the stack as
+ * it was. The buffer doubles when full and never shrinks by itself;
+ * shrink() and shrink_to_fit() give memory back when the caller wants to.
+ */
+template <typename T, typename Allocator = std::allocator<T>>
+class Stack {
+  using Traits = std::allocator_traits<Allocator>;
+
+  Allocator allocator_;
+  T* data_;
+  size_t size_;
+  size_t capacity_;
+
+  // Moves the elements into a buffer of new_capacity >= size_ elements.
+  void Reallocate(size_t new_capacity);
+
+  // Constructs an element at position size_ of a buffer of new_capacity and
+  // moves the others after it, so args may refer to an element.
+  template <typename... Args>
+  void GrowAndEmplace(size_t new_capacity, Args&&... args);
+
+  void DestroyAll() {
+    pop(size_);
+  }
+
+  void Release() {
+    DestroyAll();
+    if (data_ != nullptr) {
+      Traits::deallocate(allocator_, data_, capacity_);
+      data_ = nullptr;
+      capacity_ = 0;
+    }
+  }
+
+public:
+  using value_type = T;
+  using allocator_type = Allocator;
+  using size_type = size_t;
+
+  Stack() : Stack(Allocator()) {}
+
+  explicit Stack(const Allocator& allocator) : allocator_(allocator), data_(nullptr), size_(0), capacity_(0) {}
+
+  Stack(const Stack& other);
+
+  Stack(Stack&& other) noexcept
+    : allocator_(std::move(other.allocator_)), data_(other.data_), size_(other.size_), capacity_(other.capacity_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.capacity_ = 0;
+  }
+
+  Stack& operator=(const Stack& other);
+
+  Stack& operator=(Stack&& other) noexcept(Traits::propagate_on_container_move_assignment::value
+                                           || Traits::is_always_equal::value);
+
+  ~Stack() {
+    Release();
+  }
+
+  void swap(Stack& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+    if constexpr (Traits::propagate_on_container_swap::value) {
+      std::swap(allocator_, other.allocator_);
+    }
+  }
+
+  Allocator get_allocator() const {
+    return allocator_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  T& top() {
+    return data_[size_ - 1];
+  }
+
+  const T& top() const {
+    return data_[size_ - 1];
+  }
+
+  // Elements from the bottom to the top.
+  T* data() {
+    return data_;
+  }
+
+  const T* data() const {
+    return data_;
+  }
+
+  T& operator[](size_t index) {
+    return data_[index];
+  }
+
+  const T& operator[](size_t index) const {
+    return data_[index];
+  }
+
+  void reserve(size_t new_capacity) {
+    if (new_capacity > capacity_) {
+      Reallocate(new_capacity);
+    }
+  }
+
+  template <typename... Args>
+  T& emplace(Args&&... args);
+
+  void push(const T& value) {
+    emplace(value);
+  }
+
+  void push(T&& value) {
+    emplace(std::move(value));
+  }
+
+  // Pushes [first, last) in order, growing the buffer at most once when the
+  // iterators can tell the distance up front. The range must not be inside
+  // this stack.
+  template <typename Iterator>
+  void push_range(Iterator first, Iterator last);
+
+  void pop() {
+    --size_;
+    Traits::destroy(allocator_, data_ + size_);
+  }
+
+  // Pops the top count elements, count <= size().
+  void pop(size_t count) {
+    if constexpr (std::is_trivially_destructible_v<T>) {
+      size_ -= count;
+    } else {
+      for (; count > 0; --count) {
+        pop();
+      }
+    }
+  }
+
+  // Destroys the elements and keeps the buffer.
+  void clear() {
+    DestroyAll();
+  }
+
+  // Brings the capacity down to max(new_capacity, size()), or frees the
+  // buffer when that is 0.
+  void shrink(size_t new_capacity) {
+    new_capacity = std::max(new_capacity, size_);
+    if (new_capacity == 0) {
+      Release();
+    } else if (new_capacity < capacity_) {
+      Reallocate(new_capacity);
+    }
+  }
+
+  void shrink_to_fit() {
+    shrink(size_);
+  }
+};
+
+template <typename T, typename Allocator>
+void Stack<T, Allocator>::Reallocate(size_t new_capacity) {
+  T* new_data = Traits::allocate(allocator_, new_capacity);
+  size_t moved = 0;
+  try {
+    for (; moved < size_; ++moved) {
+      Traits::construct(allocator_, new_data + moved, std::move_if_noexcept(data_[moved]));
+    }
+  } catch (...) {
+    for (; moved > 0; --moved) {
+      Traits::destroy(allocator_, new_data + moved - 1);
+    }
+    Traits::deallocate(allocator_, new_data, new_capacity);
+    throw;
+  }
+  size_t size = size_;
+  Release();
+  data_ = new_data;
+  size_ = size;
+  capacity_ = new_capacity;
+}
+
+template <typename T, typename Allocator>
+template <typename... Args>
+void Stack<T, Allocator>::GrowAndEmplace(size_t new_capacity, Args&&... args) {
+  T* new_data = Traits::allocate(allocator_, new_capacity);
+  try {
+    Traits::construct(allocator_, new_data + size_, std::forward<Args>(args)...);
+  } catch (...) {
+    Traits::deallocate(allocator_, new_data, new_capacity);
+    throw;
+  }
+  size_t moved = 0;
+  try {
+    for (; moved < size_; ++moved) {
+      Traits::construct(allocator_, new_data + moved, std::move_if_noexcept(data_[moved]));
+    }
+  } catch (...) {
+    for (; moved > 0; --moved) {
+      Traits::destroy(allocator_, new_data + moved - 1);
+    }
+    Traits::destroy(allocator_, new_data + size_);
+    Traits::deallocate(allocator_, new_data, new_capacity);
+    throw;
+  }
+  size_t size = size_;
+  Release();
+  data_ = new_data;
+  size_ = size + 1;
+  capacity_ = new_capacity;
+}
+
+template <typename T, typename Allocator>
+template <typename... Args>
+T& Stack<T, Allocator>::emplace(Args&&... args) {
+  if (size_ == capacity_) {
+    GrowAndEmplace(capacity_ == 0 ? 1 : 2 * capacity_, std::forward<Args>(args)...);
+  } else {
+    Traits::construct(allocator_, data_ + size_, std::forward<Args>(args)...);
+    ++size_;
+  }
+  return top();
+}
+
+template <typename T, typename Allocator>
+template <typename Iterator>
+void Stack<T, Allocator>::push_range(Iterator first, Iterator last) {
+  using Category = typename std::iterator_traits<Iterator>::iterator_category;
+  if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+    size_t count = static_cast<size_t>(std::distance(first, last));
+    if (size_ + count > capacity_) {
+      reserve(std::max(size_ + count, 2 * capacity_));
+    }
+    // The room is there, so no capacity checks per element.
+    for (; first != last; ++first) {
+      Traits::construct(allocator_, data_ + size_, *first);
+      ++size_;
+    }
+  } else {
+    for (; first != last; ++first) {
+      emplace(*first);
+    }
+  }
+}
+
+template <typename T, typename Allocator>
+Stack<T, Allocator>::Stack(const Stack& other)
+  : allocator_(Traits::select_on_container_copy_construction(other.allocator_))
+  , data_(nullptr)
+  , size_(0)
+  , capacity_(0) {
+  reserve(other.size_);
+  push_range(other.data_, other.data_ + other.size_);
+}
+
+template <typename T, typename Allocator>
+Stack<T, Allocator>& Stack<T, Allocator>::operator=(const Stack& other) {
+  if (this != &other) {
+    if constexpr (Traits::propagate_on_container_copy_assignment::value) {
+      if (allocator_ != other.allocator_) {
+        Release();
+      }
+      allocator_ = other.allocator_;
+    }
+    clear();
+    reserve(other.size_);
+    push_range(other.data_, other.data_ + other.size_);
+  }
+  return *this;
+}
+
+template <typename T, typename Allocator>
+Stack<T, Allocator>& Stack<T, Allocator>::operator=(Stack&& other) noexcept(
+    Traits::propagate_on_container_move_assignment::value || Traits::is_always_equal::value) {
+  if (this == &other) {
+    return *this;
+  }
+  if constexpr (Traits::propagate_on_container_move_assignment::value) {
+    Release();
+    allocator_ = std::move(other.allocator_);
+  } else if (allocator_ != other.allocator_) {
+    // The buffer belongs to another allocator: move the elements one by one.
+    clear();
+    reserve(other.size_);
+    for (size_t i = 0; i < other.size_; ++i) {
+      emplace(std::move(other.data_[i]));
+    }
+    other.clear();
+    return *this;
+  } else {
+    Release();
+  }
+  data_ = other.data_;
+  size_ = other.size_;
+  capacity_ = other.capacity_;
+  other.data_ = nullptr;
+  other.size_ = 0;
+  other.capacity_ = 0;
+  return *this;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+
+#include "stack.h"
+
+// Stack of words on two Stacks: the words themselves, each followed by '\0',
+// back to back in bytes, and the offset of every word in offsets. A push
+// appends its chars with one push_range and a pop drops them with one bulk
+// pop, so no word ever gets its own allocation.
+
+const size_t word_stack_min_capacity = 64;
+
+void push_word(Stack<char>& bytes, Stack<size_t>& offsets, const char* word, size_t length) {
+  offsets.push(bytes.size());
+  bytes.push_range(word, word + length);
+  bytes.push('\0');
+}
+
+// The top word, valid until the next push, pop or clear; offsets must not be
+// empty.
+const char* top_word(const Stack<char>& bytes, const Stack<size_t>& offsets) {
+  return bytes.data() + offsets.top();
+}
+
+// Stack never shrinks by itself, so a buffer is halved here once three
+// quarters of it are unused; it is then half full, so neither a push nor a
+// pop right after moves it again.
+void shrink_words(Stack<char>& bytes, Stack<size_t>& offsets) {
+  if (bytes.capacity() > word_stack_min_capacity && bytes.size() <= bytes.capacity() / 4) {
+    bytes.shrink(bytes.capacity() / 2);
+  }
+  if (offsets.capacity() > word_stack_min_capacity && offsets.size() <= offsets.capacity() / 4) {
+    offsets.shrink(offsets.capacity() / 2);
+  }
+}
+
+void pop_word(Stack<char>& bytes, Stack<size_t>& offsets) {
+  bytes.pop(bytes.size() - offsets.top());
+  offsets.pop();
+  shrink_words(bytes, offsets);
+}
+
+void clear_words(Stack<char>& bytes, Stack<size_t>& offsets) {
+  bytes.clear();
+  offsets.clear();
+  bytes.shrink_to_fit();
+  offsets.shrink_to_fit();
+}
@@ -0,0 +1,258 @@
+/*
+ * Short-string microbenchmark: make benchmark && ./benchmark [ops]
+ *
+ * Runs the same key-shaped workloads on String and std::string and prints,
+ * as CSV, the time and the number of heap allocations per operation. Every
+ * global operator new is counted, so allocations made by the workload's own
+ * containers are reserved up front and never show up in the numbers.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "string.h"
+#include "string_builder.h"
+
+namespace {
+
+size_t allocations = 0;
+
+}  // namespace
+
+void* operator new(size_t size) {
+  ++allocations;
+  if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+  std::free(pointer);
+}
+
+namespace {
+
+// Keys of 3..20 chars, the typical size of identifiers and map keys.
+std::vector<std::string> makeKeys(size_t count) {
+  std::mt19937_64 random(2024);
+  std::uniform_int_distribution<size_t> length(3, 20);
+  std::uniform_int_distribution<int> letter('a', 'z');
+  std::vector<std::string> keys(count);
+  for (std::string& key : keys) {
+    key.resize(length(random));
+    for (char& c : key) {
+      c = static_cast<char>(letter(random));
+    }
+  }
+  return keys;
+}
+
+template <typename Work>
+void report(const char* name, const char* type, size_t ops, Work work) {
+  size_t allocations_before = allocations;
+  auto start = std::chrono::steady_clock::now();
+  size_t checksum = work();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double per_op = static_cast<double>(ops);
+  std::printf("%s,%s,%zu,%.6f,%.2f,%.3f,%zu\n", name, type, ops, seconds, 1e9 * seconds / per_op,
+              static_cast<double>(allocations - allocations_before) / per_op, checksum);
+}
+
+template <typename Str>
+void run(const char* type, const std::vector<std::string>& keys) {
+  size_t n = keys.size();
+  std::vector<Str> strings;
+  strings.reserve(n);
+  std::vector<Str> results;
+  results.reserve(n);
+
+  report("construct", type, n, [&]() {
+    for (const std::string& key : keys) {
+      strings.emplace_back(key.c_str());
+    }
+    return strings.size();
+  });
+  report("copy", type, n, [&]() {
+    size_t total = 0;
+    for (const Str& string : strings) {
+      Str copy(string);
+      total += copy.size();
+    }
+    return total;
+  });
+  report("assign", type, n, [&]() {
+    Str target;
+    size_t total = 0;
+    for (const Str& string : strings) {
+      target = string;
+      total += target.size();
+    }
+    return total;
+  });
+  report("push_back", type, n, [&]() {
+    size_t total = 0;
+    for (const std::string& key : keys) {
+      Str built;
+      for (char c : key) {
+        built.push_back(c);
+      }
+      total += built.size();
+    }
+    return total;
+  });
+  report("prefix+key", type, n, [&]() {
+    for (const Str& string : strings) {
+      results.push_back("id:" + string);
+    }
+    return results.size();
+  });
+  report("substr", type, n, [&]() {
+    size_t total = 0;
+    for (const Str& string : strings) {
+      total += string.substr(1, 8).size();
+    }
+    return total;
+  });
+  report("move", type, n, [&]() {
+    std::vector<Str> moved;
+    size_t before = allocations;
+    moved.reserve(n);
+    allocations = before;
+    for (Str& string : results) {
+      moved.push_back(std::move(string));
+    }
+    return moved.size();
+  });
+  report("append", type, n, [&]() {
+    Str document;
+    for (const Str& string : strings) {
+      document += string.data();
+      document += ' ';
+    }
+    return document.size();
+  });
+
+  std::string text;
+  for (const std::string& key : keys) {
+    text += key;
+    text += ' ';
+  }
+  std::istringstream in(text);
+  report("operator>>", type, n, [&]() {
+    size_t total = 0;
+    Str token;
+    while (in >> token) {
+      total += token.size();
+    }
+    return total;
+  });
+}
+
+// Tokenizing one space-separated document: owning substr per token against
+// views from the lazy split.
+void runTokenize(const std::vector<std::string>& keys) {
+  String document;
+  for (const std::string& key : keys) {
+    document += key.c_str();
+    document += ' ';
+  }
+  size_t n = keys.size();
+  report("tokenize", "String::substr", n, [&]() {
+    size_t total = 0;
+    size_t start = 0;
+    for (size_t end = 0; end < document.size(); ++end) {
+      if (document[end] == ' ') {
+        total += document.substr(start, end - start).size();
+        start = end + 1;
+      }
+    }
+    return total;
+  });
+  report("tokenize", "StringView::splitRange", n, [&]() {
+    size_t total = 0;
+    for (StringView token : StringView(document).splitRange(" ")) {
+      total += token.size();
+    }
+    return total;
+  });
+}
+
+// Composing "key=" + key + ':' + key + ';' from parts: a chain of + against
+// one allocation through Concat, StringBuilder and STRING_FORMAT.
+void runCompose(const std::vector<std::string>& keys) {
+  std::vector<String> strings;
+  strings.reserve(keys.size());
+  for (const std::string& key : keys) {
+    strings.emplace_back(key.c_str());
+  }
+  size_t n = keys.size();
+  report("compose", "std::string+", n, [&]() {
+    size_t total = 0;
+    for (const std::string& key : keys) {
+      total += ("key=" + key + ':' + key + ';').size();
+    }
+    return total;
+  });
+  report("compose", "String+", n, [&]() {
+    size_t total = 0;
+    for (const String& string : strings) {
+      total += ("key=" + string + ':' + string + ';').size();
+    }
+    return total;
+  });
+  report("compose", "Concat", n, [&]() {
+    size_t total = 0;
+    for (const String& string : strings) {
+      total += Concat("key=", string, ':', string, ';').size();
+    }
+    return total;
+  });
+  StringBuilder builder;
+  builder.reserve(5);
+  report("compose", "StringBuilder", n, [&]() {
+    size_t total = 0;
+    for (const String& string : strings) {
+      builder.clear();
+      builder << "key=" << string << ':' << string << ';';
+      total += builder.build().size();
+    }
+    return total;
+  });
+  report("compose", "STRING_FORMAT", n, [&]() {
+    size_t total = 0;
+    for (const String& string : strings) {
+      total += STRING_FORMAT("key={}:{};", string, string).size();
+    }
+    return total;
+  });
+  report("compose", "STRING_FORMAT+int", n, [&]() {
+    size_t total = 0;
+    for (size_t i = 0; i < n; ++i) {
+      total += STRING_FORMAT("{}#{}", strings[i], i).size();
+    }
+    return total;
+  });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t ops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+  std::vector<std::string> keys = makeKeys(ops);
+  std::printf("case,type,ops,seconds,ns_per_op,allocs_per_op,checksum\n");
+  run<String>("String", keys);
+  run<std::string>("std::string", keys);
+  runTokenize(keys);
+  runCompose(keys);
+}
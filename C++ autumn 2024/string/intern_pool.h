@@ -0,0 +1,252 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "string_view.h"
+
+/*
+ * Handle of an interned string: the index of its entry in the pool. Two
+ * symbols of the same pool are equal exactly when their strings are, so
+ * comparing and hashing them is O(1) and never touches the chars.
+ */
+class Symbol {
+  uint32_t id_;
+
+public:
+  static constexpr uint32_t kNone = UINT32_MAX;
+
+  Symbol() : id_(kNone) {}
+
+  explicit Symbol(uint32_t id) : id_(id) {}
+
+  uint32_t id() const {
+    return id_;
+  }
+
+  bool valid() const {
+    return id_ != kNone;
+  }
+};
+
+bool operator==(Symbol a, Symbol b) {
+  return a.id() == b.id();
+}
+
+bool operator!=(Symbol a, Symbol b) {
+  return a.id() != b.id();
+}
+
+bool operator<(Symbol a, Symbol b) {
+  return a.id() < b.id();
+}
+
+namespace std {
+
+template <>
+struct hash<Symbol> {
+  size_t operator()(Symbol symbol) const {
+    return symbol.id();
+  }
+};
+
+}  // namespace std
+
+/*
+ * Interning pool: every distinct string is stored once, null-terminated, in
+ * big blocks carved out by a bump pointer, and looked up through an open
+ * addressing table with linear probing that keeps full hashes next to the
+ * ids, so a probe compares chars only on a hash hit. Nothing is freed
+ * individually: the blocks go away together with the pool, and views and
+ * symbols it handed out are valid until then.
+ */
+class InternPool {
+  struct Entry {
+    const char* data;
+    uint32_t size;
+    uint32_t hash;
+  };
+
+  struct Slot {
+    uint32_t id;
+    uint32_t hash;
+  };
+
+  static constexpr size_t kBlockSize = 64 * 1024;
+  static constexpr size_t kInitialSlots = 64;
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char* cursor_;
+  size_t remaining_;
+  size_t bytes_;
+  std::vector<Entry> entries_;
+  std::vector<Slot> slots_;
+
+  static uint32_t Hash(StringView string);
+
+  const char* Store(StringView string);
+
+  void Rehash(size_t slot_count);
+
+  size_t Probe(StringView string, uint32_t hash) const;
+
+public:
+  InternPool()
+    : blocks_()
+    , cursor_(nullptr)
+    , remaining_(0)
+    , bytes_(0)
+    , entries_()
+    , slots_(kInitialSlots, {Symbol::kNone, 0}) {}
+
+  InternPool(const InternPool&) = delete;
+
+  InternPool& operator=(const InternPool&) = delete;
+
+  // The moved-from pool is left empty but usable, with a fresh slot table.
+  InternPool(InternPool&& other) noexcept
+    : blocks_(std::move(other.blocks_))
+    , cursor_(other.cursor_)
+    , remaining_(other.remaining_)
+    , bytes_(other.bytes_)
+    , entries_(std::move(other.entries_))
+    , slots_(std::move(other.slots_)) {
+    other.clear();
+  }
+
+  InternPool& operator=(InternPool&& other) noexcept {
+    if (this != &other) {
+      blocks_ = std::move(other.blocks_);
+      cursor_ = other.cursor_;
+      remaining_ = other.remaining_;
+      bytes_ = other.bytes_;
+      entries_ = std::move(other.entries_);
+      slots_ = std::move(other.slots_);
+      other.clear();
+    }
+    return *this;
+  }
+
+  // The symbol of string, adding it on first sight.
+  Symbol intern(StringView string);
+
+  // The symbol of string if it was interned, an invalid one otherwise.
+  Symbol find(StringView string) const;
+
+  StringView view(Symbol symbol) const {
+    const Entry& entry = entries_[symbol.id()];
+    return StringView(entry.data, entry.size);
+  }
+
+  const char* c_str(Symbol symbol) const {
+    return entries_[symbol.id()].data;
+  }
+
+  size_t hash(Symbol symbol) const {
+    return entries_[symbol.id()].hash;
+  }
+
+  // Number of distinct strings.
+  size_t size() const {
+    return entries_.size();
+  }
+
+  // Arena bytes taken by the strings, terminators included.
+  size_t bytes() const {
+    return bytes_;
+  }
+
+  void clear();
+};
+
+// The low half of the String hash; the table only uses low bits anyway.
+uint32_t InternPool::Hash(StringView string) {
+  return static_cast<uint32_t>(HashBytes(string.data(), string.size()));
+}
+
+const char* InternPool::Store(StringView string) {
+  size_t needed = string.size() + 1;
+  if (needed > remaining_) {
+    // Strings longer than a quarter block get a block of their own, so that
+    // they do not waste the tail of the current one.
+    if (needed > kBlockSize / 4) {
+      blocks_.emplace_back(new char[needed]);
+      char* own = blocks_.back().get();
+      std::copy(string.begin(), string.end(), own);
+      own[string.size()] = '\0';
+      bytes_ += needed;
+      return own;
+    }
+    blocks_.emplace_back(new char[kBlockSize]);
+    cursor_ = blocks_.back().get();
+    remaining_ = kBlockSize;
+  }
+  char* stored = cursor_;
+  std::copy(string.begin(), string.end(), stored);
+  stored[string.size()] = '\0';
+  cursor_ += needed;
+  remaining_ -= needed;
+  bytes_ += needed;
+  return stored;
+}
+
+// Slot holding string, or the empty slot where it would go.
+size_t InternPool::Probe(StringView string, uint32_t hash) const {
+  size_t mask = slots_.size() - 1;
+  for (size_t index = hash & mask;; index = (index + 1) & mask) {
+    const Slot& slot = slots_[index];
+    if (slot.id == Symbol::kNone) {
+      return index;
+    }
+    if (slot.hash == hash && view(Symbol(slot.id)) == string) {
+      return index;
+    }
+  }
+}
+
+void InternPool::Rehash(size_t slot_count) {
+  std::vector<Slot> old_slots(slot_count, {Symbol::kNone, 0});
+  old_slots.swap(slots_);
+  size_t mask = slots_.size() - 1;
+  for (const Slot& slot : old_slots) {
+    if (slot.id == Symbol::kNone) {
+      continue;
+    }
+    size_t index = slot.hash & mask;
+    while (slots_[index].id != Symbol::kNone) {
+      index = (index + 1) & mask;
+    }
+    slots_[index] = slot;
+  }
+}
+
+Symbol InternPool::intern(StringView string) {
+  uint32_t hash = Hash(string);
+  size_t index = Probe(string, hash);
+  if (slots_[index].id != Symbol::kNone) {
+    return Symbol(slots_[index].id);
+  }
+  uint32_t id = static_cast<uint32_t>(entries_.size());
+  entries_.push_back({Store(string), static_cast<uint32_t>(string.size()), hash});
+  slots_[index] = {id, hash};
+  // Keep the load factor at most 1/2, so that probe runs stay short.
+  if (2 * entries_.size() > slots_.size()) {
+    Rehash(2 * slots_.size());
+  }
+  return Symbol(id);
+}
+
+Symbol InternPool::find(StringView string) const {
+  return Symbol(slots_[Probe(string, Hash(string))].id);
+}
+
+void InternPool::clear() {
+  blocks_.clear();
+  cursor_ = nullptr;
+  remaining_ = 0;
+  bytes_ = 0;
+  entries_.clear();
+  slots_.assign(kInitialSlots, {Symbol::kNone, 0});
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <string>
+#include <system_error>
+
+#include "string_view.h"
+
+/*
+ * Read-only mapping of a whole file. The chars are never copied to the heap:
+ * view() is a StringView over the mapping, so find, rfind, substr, split and
+ * the comparisons work on a multi-gigabyte file as on any String, and the
+ * kernel pages it in on demand. The view is valid while the MappedFile
+ * lives. Mapping or opening failures throw std::system_error.
+ */
+class MappedFile {
+  const char* data_;
+  size_t size_;
+
+  void Unmap() {
+    if (data_ != nullptr) {
+      munmap(const_cast<char*>(data_), size_);
+      data_ = nullptr;
+      size_ = 0;
+    }
+  }
+
+public:
+  // How the pages are going to be read, passed on to madvise.
+  enum class Access {
+    kNormal,
+    kSequential,
+    kRandom,
+    kWillNeed,
+  };
+
+  MappedFile() : data_(nullptr), size_(0) {}
+
+  // Sequential access fits a scan from start to end: the kernel reads ahead
+  // aggressively and may drop pages soon after they were read.
+  explicit MappedFile(const char* path, Access access = Access::kSequential);
+
+  MappedFile(const MappedFile&) = delete;
+
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& other) noexcept : data_(other.data_), size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+
+  MappedFile& operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+      Unmap();
+      std::swap(data_, other.data_);
+      std::swap(size_, other.size_);
+    }
+    return *this;
+  }
+
+  ~MappedFile() {
+    Unmap();
+  }
+
+  const char* data() const {
+    return size_ == 0 ? "" : data_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  StringView view() const {
+    return StringView(data(), size_);
+  }
+
+  operator StringView() const {
+    return view();
+  }
+
+  // Hint for the pages covering [start, start + count). Hints are advisory,
+  // so a refused one is ignored.
+  void advise(Access access, size_t start, size_t count) const;
+
+  void advise(Access access) const {
+    advise(access, 0, size_);
+  }
+};
+
+MappedFile::MappedFile(const char* path, Access access) : data_(nullptr), size_(0) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), std::string("open ") + path);
+  }
+  struct stat status = {};
+  if (fstat(fd, &status) != 0) {
+    int error = errno;
+    close(fd);
+    throw std::system_error(error, std::generic_category(), std::string("fstat ") + path);
+  }
+  size_t size = static_cast<size_t>(status.st_size);
+  // mmap refuses empty lengths; an empty file is an empty view.
+  if (size > 0) {
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      int error = errno;
+      close(fd);
+      throw std::system_error(error, std::generic_category(), std::string("mmap ") + path);
+    }
+    data_ = static_cast<const char*>(mapping);
+    size_ = size;
+  }
+  // The mapping keeps the file referenced on its own.
+  close(fd);
+  advise(access);
+}
+
+void MappedFile::advise(Access access, size_t start, size_t count) const {
+  if (data_ == nullptr || start >= size_) {
+    return;
+  }
+  int advice = MADV_NORMAL;
+  switch (access) {
+    case Access::kNormal:
+      advice = MADV_NORMAL;
+      break;
+    case Access::kSequential:
+      advice = MADV_SEQUENTIAL;
+      break;
+    case Access::kRandom:
+      advice = MADV_RANDOM;
+      break;
+    case Access::kWillNeed:
+      advice = MADV_WILLNEED;
+      break;
+    default:
+      break;
+  }
+  // madvise wants a page-aligned start.
+  size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t aligned = start / page * page;
+  size_t end = std::min(size_, start + count);
+  madvise(const_cast<char*>(data_) + aligned, end - aligned, advice);
+}
@@ -0,0 +1,395 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "string.h"
+#include "string_search.h"
+#include "string_view.h"
+
+/*
+ * Fixed set of worker threads running batches of indexed tasks. The calling
+ * thread works on its own batch too, so a pool of size() threads has
+ * size() - 1 workers, and a pool on a single-core machine runs everything
+ * inline. Batches run one at a time; a task must not throw or start another
+ * batch on the same pool.
+ */
+class ThreadPool {
+  std::vector<std::thread> workers_;
+  std::mutex batch_mutex_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable finish_;
+  const std::function<void(size_t)>* task_;
+  size_t task_count_;
+  std::atomic<size_t> next_task_;
+  size_t running_;
+  uint64_t batch_;
+  bool stopping_;
+
+  // Indices are handed out in increasing order.
+  void RunTasks() {
+    for (size_t index = next_task_++; index < task_count_; index = next_task_++) {
+      (*task_)(index);
+    }
+  }
+
+  void WorkerLoop();
+
+public:
+  // threads == 0 takes one thread per hardware thread.
+  explicit ThreadPool(size_t threads = 0);
+
+  ThreadPool(const ThreadPool&) = delete;
+
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool();
+
+  size_t size() const {
+    return workers_.size() + 1;
+  }
+
+  // Runs task(i) for every i in [0, count) and returns when all are done.
+  void parallelFor(size_t count, const std::function<void(size_t)>& task);
+};
+
+ThreadPool::ThreadPool(size_t threads)
+  : workers_()
+  , batch_mutex_()
+  , mutex_()
+  , start_()
+  , finish_()
+  , task_(nullptr)
+  , task_count_(0)
+  , next_task_(0)
+  , running_(0)
+  , batch_(0)
+  , stopping_(false) {
+  if (threads == 0) {
+    threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+  workers_.reserve(threads - 1);
+  for (size_t i = 1; i < threads; ++i) {
+    workers_.emplace_back([this]() { WorkerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  start_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::WorkerLoop() {
+  uint64_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_.wait(lock, [&]() { return stopping_ || batch_ != seen; });
+      if (stopping_) {
+        return;
+      }
+      seen = batch_;
+    }
+    RunTasks();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--running_ == 0) {
+      finish_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+  if (workers_.empty() || count <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      task(i);
+    }
+    return;
+  }
+  std::lock_guard<std::mutex> batch(batch_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    task_count_ = count;
+    next_task_ = 0;
+    running_ = workers_.size();
+    ++batch_;
+  }
+  start_.notify_all();
+  RunTasks();
+  std::unique_lock<std::mutex> lock(mutex_);
+  finish_.wait(lock, [this]() { return running_ == 0; });
+}
+
+// Process-wide pool with a thread per hardware thread, started on first use.
+ThreadPool& DefaultThreadPool() {
+  static ThreadPool pool;
+  return pool;
+}
+
+/*
+ * Substring search split across threads, for texts far larger than a cache,
+ * such as a MappedFile. The possible match starts are cut into chunks of
+ * kChunkSize; a chunk's window reaches needle size - 1 chars into the next
+ * one, so a match crossing a boundary is seen whole, and it belongs to the
+ * chunk where it starts, so no match is reported twice. Chunk results are
+ * merged in text order.
+ *
+ * For find and rfind, once a match is known, chunks that can only hold
+ * worse matches are skipped, so the search stops soon after the answer is
+ * found rather than scanning the whole text.
+ */
+
+namespace detail {
+
+constexpr size_t kChunkSize = size_t{4} << 20;
+
+// Texts shorter than this are one chunk, searched on the calling thread.
+constexpr size_t kParallelThreshold = size_t{8} << 20;
+
+// Match starts [0, starts) of a needle in a text, cut into chunks.
+class Chunking {
+  size_t starts_;
+  size_t chunk_size_;
+
+public:
+  Chunking(size_t n, size_t m)
+    : starts_(n - m + 1), chunk_size_(n < kParallelThreshold ? starts_ : kChunkSize) {}
+
+  size_t count() const {
+    return (starts_ + chunk_size_ - 1) / chunk_size_;
+  }
+
+  size_t begin(size_t chunk) const {
+    return chunk * chunk_size_;
+  }
+
+  size_t end(size_t chunk) const {
+    return std::min(begin(chunk) + chunk_size_, starts_);
+  }
+};
+
+// Calls visit(position) for the matches starting in [begin, end), every
+// one if step is 1, or leftmost non-overlapping ones if step is the needle
+// size. Stops early when visit returns false.
+template <typename Visit>
+void ScanChunk(StringView text, const Pattern& pattern, size_t begin, size_t end, size_t step, Visit visit) {
+  size_t window = end - begin + pattern.size() - 1;
+  const char* data = text.data() + begin;
+  for (size_t found = pattern.find(data, window); found != window; found = pattern.find(data, window, found + step)) {
+    if (!visit(begin + found)) {
+      return;
+    }
+  }
+}
+
+}  // namespace detail
+
+// Leftmost occurrence of needle in text, or text.size(), as StringView::find.
+size_t ParallelFind(StringView text, StringView needle, ThreadPool& pool = DefaultThreadPool()) {
+  size_t n = text.size();
+  size_t m = needle.size();
+  if (m == 0 || m > n || n < detail::kParallelThreshold) {
+    return text.find(needle);
+  }
+  const Pattern pattern(needle.data(), m);
+  const detail::Chunking chunking(n, m);
+  std::atomic<size_t> best(n);
+  pool.parallelFor(chunking.count(), [&](size_t chunk) {
+    // Chunks are handed out in order, so once this one starts after the
+    // best match, every later one does as well.
+    if (chunking.begin(chunk) >= best.load(std::memory_order_relaxed)) {
+      return;
+    }
+    detail::ScanChunk(text, pattern, chunking.begin(chunk), chunking.end(chunk), 1, [&](size_t position) {
+      size_t current = best.load(std::memory_order_relaxed);
+      while (position < current && !best.compare_exchange_weak(current, position)) {
+      }
+      return false;
+    });
+  });
+  return best.load();
+}
+
+// Rightmost occurrence of needle in text, or text.size(), as
+// StringView::rfind. Chunks are handed out from the end of the text.
+size_t ParallelRfind(StringView text, StringView needle, ThreadPool& pool = DefaultThreadPool()) {
+  size_t n = text.size();
+  size_t m = needle.size();
+  if (m == 0 || m > n || n < detail::kParallelThreshold) {
+    return text.rfind(needle);
+  }
+  const Pattern pattern(needle.data(), m);
+  const detail::Chunking chunking(n, m);
+  size_t chunks = chunking.count();
+  // One past the best match start, 0 while there is none.
+  std::atomic<size_t> best_end(0);
+  pool.parallelFor(chunks, [&](size_t index) {
+    size_t chunk = chunks - 1 - index;
+    size_t begin = chunking.begin(chunk);
+    size_t end = chunking.end(chunk);
+    if (end <= best_end.load(std::memory_order_relaxed)) {
+      return;
+    }
+    size_t window = end - begin + m - 1;
+    size_t found = pattern.rfind(text.data() + begin, window);
+    if (found == window) {
+      return;
+    }
+    size_t position_end = begin + found + 1;
+    size_t current = best_end.load(std::memory_order_relaxed);
+    while (position_end > current && !best_end.compare_exchange_weak(current, position_end)) {
+    }
+  });
+  size_t found_end = best_end.load();
+  return found_end == 0 ? n : found_end - 1;
+}
+
+// Starts of all occurrences of needle, overlapping ones included, in
+// increasing order. An empty needle has no occurrences here.
+std::vector<size_t> ParallelFindAll(StringView text, StringView needle, ThreadPool& pool = DefaultThreadPool()) {
+  size_t n = text.size();
+  size_t m = needle.size();
+  if (m == 0 || m > n) {
+    return {};
+  }
+  const Pattern pattern(needle.data(), m);
+  const detail::Chunking chunking(n, m);
+  std::vector<std::vector<size_t>> found(chunking.count());
+  pool.parallelFor(found.size(), [&](size_t chunk) {
+    detail::ScanChunk(text, pattern, chunking.begin(chunk), chunking.end(chunk), 1, [&](size_t position) {
+      found[chunk].push_back(position);
+      return true;
+    });
+  });
+  // Prefix sums place every chunk's positions, which are then copied in
+  // parallel.
+  std::vector<size_t> offsets(found.size() + 1, 0);
+  for (size_t chunk = 0; chunk < found.size(); ++chunk) {
+    offsets[chunk + 1] = offsets[chunk] + found[chunk].size();
+  }
+  std::vector<size_t> positions(offsets.back());
+  pool.parallelFor(found.size(), [&](size_t chunk) {
+    std::copy(found[chunk].begin(), found[chunk].end(), positions.begin() + static_cast<ptrdiff_t>(offsets[chunk]));
+  });
+  return positions;
+}
+
+// Number of occurrences of needle, overlapping ones included.
+size_t ParallelCount(StringView text, StringView needle, ThreadPool& pool = DefaultThreadPool()) {
+  size_t n = text.size();
+  size_t m = needle.size();
+  if (m == 0 || m > n) {
+    return 0;
+  }
+  const Pattern pattern(needle.data(), m);
+  const detail::Chunking chunking(n, m);
+  std::vector<size_t> counts(chunking.count(), 0);
+  pool.parallelFor(counts.size(), [&](size_t chunk) {
+    detail::ScanChunk(text, pattern, chunking.begin(chunk), chunking.end(chunk), 1, [&](size_t) {
+      ++counts[chunk];
+      return true;
+    });
+  });
+  size_t total = 0;
+  for (size_t count : counts) {
+    total += count;
+  }
+  return total;
+}
+
+/*
+ * Copy of text with every leftmost non-overlapping occurrence of needle
+ * replaced, scanning left to right as a sequential replace loop would. An
+ * empty needle replaces nothing.
+ *
+ * Three passes. Every chunk first collects its matches as if the scan began
+ * at the chunk start. A sequential pass over the chunks then drops matches
+ * overlapped by one kept in the chunk before, rescanning only until the
+ * chunk's own matches line up again, and takes prefix sums of the kept
+ * matches. Those give every chunk its place in the output, so the chunks
+ * are written concurrently into a String allocated once.
+ */
+String ParallelReplaceAll(StringView text, StringView needle, StringView replacement,
+                          ThreadPool& pool = DefaultThreadPool()) {
+  size_t n = text.size();
+  size_t m = needle.size();
+  if (m == 0 || m > n) {
+    return String(text);
+  }
+  const Pattern pattern(needle.data(), m);
+  const detail::Chunking chunking(n, m);
+  size_t chunks = chunking.count();
+  std::vector<std::vector<size_t>> matches(chunks);
+  pool.parallelFor(chunks, [&](size_t chunk) {
+    detail::ScanChunk(text, pattern, chunking.begin(chunk), chunking.end(chunk), m, [&](size_t position) {
+      matches[chunk].push_back(position);
+      return true;
+    });
+  });
+
+  // copy_from[chunk] is where the chunk's share of the text begins: its
+  // start, or the end of a match kept in the chunk before.
+  std::vector<size_t> copy_from(chunks + 1, n);
+  std::vector<size_t> kept_before(chunks + 1, 0);
+  size_t covered = 0;
+  for (size_t chunk = 0; chunk < chunks; ++chunk) {
+    std::vector<size_t>& list = matches[chunk];
+    copy_from[chunk] = std::max(chunking.begin(chunk), covered);
+    if (covered >= chunking.end(chunk)) {
+      list.clear();
+    } else if (!list.empty() && list.front() < covered) {
+      std::vector<size_t> fixed;
+      size_t next = 0;
+      bool aligned = false;
+      detail::ScanChunk(text, pattern, covered, chunking.end(chunk), m, [&](size_t position) {
+        while (next < list.size() && list[next] < position) {
+          ++next;
+        }
+        if (next < list.size() && list[next] == position) {
+          aligned = true;
+          return false;
+        }
+        fixed.push_back(position);
+        return true;
+      });
+      if (aligned) {
+        fixed.insert(fixed.end(), list.begin() + static_cast<ptrdiff_t>(next), list.end());
+      }
+      list.swap(fixed);
+    }
+    if (!list.empty()) {
+      covered = list.back() + m;
+    }
+    kept_before[chunk + 1] = kept_before[chunk] + list.size();
+  }
+
+  size_t total = kept_before[chunks];
+  String result;
+  result.resize_and_overwrite(n - total * m + total * replacement.size(), [&](char* out, size_t size) {
+    pool.parallelFor(chunks, [&](size_t chunk) {
+      size_t cursor = copy_from[chunk];
+      // Everything before cursor is either copied as is or replaced.
+      char* write = out + cursor - kept_before[chunk] * m + kept_before[chunk] * replacement.size();
+      for (size_t position : matches[chunk]) {
+        write = std::copy(text.data() + cursor, text.data() + position, write);
+        write = std::copy(replacement.begin(), replacement.end(), write);
+        cursor = position + m;
+      }
+      std::copy(text.data() + cursor, text.data() + std::max(cursor, copy_from[chunk + 1]), write);
+    });
+    return size;
+  });
+  return result;
+}
@@ -0,0 +1,336 @@
+#pragma once
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <utility>
+
+#include "string.h"
+
+/*
+ * Immutable rope: a height-balanced (AVL) tree whose leaves are slices of
+ * shared String buffers. Nodes are never modified after construction, so a
+ * concatenation or split copies only the O(log n) nodes on its path and the
+ * operands stay valid and share everything else. Appending a short piece
+ * merges it into the neighbouring leaf while that stays under kMergeLimit,
+ * so building a document from many small parts does not leave tiny leaves.
+ */
+class Rope {
+  struct Node;
+  using NodePtr = std::shared_ptr<const Node>;
+
+  struct Node {
+    NodePtr left;
+    NodePtr right;
+    std::shared_ptr<const String> buffer;
+    size_t offset;
+    size_t size;
+    int height;
+
+    Node(NodePtr first, NodePtr second)
+      : left(std::move(first))
+      , right(std::move(second))
+      , buffer()
+      , offset(0)
+      , size(left->size + right->size)
+      , height(std::max(left->height, right->height) + 1) {}
+
+    Node(std::shared_ptr<const String> chars, size_t start, size_t count)
+      : left(), right(), buffer(std::move(chars)), offset(start), size(count), height(0) {}
+
+    bool IsLeaf() const {
+      return !left;
+    }
+
+    const char* Chars() const {
+      return buffer->data() + offset;
+    }
+  };
+
+  static constexpr size_t kMergeLimit = 128;
+
+  explicit Rope(NodePtr root) : root_(std::move(root)) {}
+
+  static NodePtr MakeNode(NodePtr left, NodePtr right) {
+    return std::make_shared<const Node>(std::move(left), std::move(right));
+  }
+
+  static NodePtr Slice(const NodePtr& leaf, size_t begin, size_t end);
+
+  static NodePtr MergeLeaves(const NodePtr& left, const NodePtr& right);
+
+  static NodePtr AbsorbRight(const NodePtr& node, const NodePtr& leaf);
+
+  static NodePtr AbsorbLeft(const NodePtr& leaf, const NodePtr& node);
+
+  static NodePtr RotateLeft(const NodePtr& node);
+
+  static NodePtr RotateRight(const NodePtr& node);
+
+  static NodePtr JoinRight(const NodePtr& left, const NodePtr& right);
+
+  static NodePtr JoinLeft(const NodePtr& left, const NodePtr& right);
+
+  static NodePtr Join(const NodePtr& left, const NodePtr& right);
+
+  static std::pair<NodePtr, NodePtr> Split(const NodePtr& node, size_t index);
+
+  template <typename Visitor>
+  static void ForEachChunk(const NodePtr& node, Visitor& visitor);
+
+  NodePtr root_;
+
+public:
+  Rope() : root_() {}
+
+  Rope(const String& string);
+
+  Rope(const char* str) : Rope(String(str)) {}
+
+  size_t size() const {
+    return root_ ? root_->size : 0;
+  }
+
+  size_t length() const {
+    return size();
+  }
+
+  bool empty() const {
+    return !root_;
+  }
+
+  // Depth of the tree, for tests and diagnostics; 0 for one leaf.
+  int height() const {
+    return root_ ? root_->height : 0;
+  }
+
+  char operator[](size_t index) const;
+
+  Rope& operator+=(const Rope& other);
+
+  // [0, index) and [index, size()).
+  std::pair<Rope, Rope> split(size_t index) const;
+
+  Rope substr(size_t start, size_t count) const;
+
+  // Inserts other before position index.
+  Rope insert(size_t index, const Rope& other) const;
+
+  Rope erase(size_t start, size_t count) const;
+
+  String flatten() const;
+
+  // Calls visitor(const char* chars, size_t count) for every leaf, in order.
+  template <typename Visitor>
+  void forEachChunk(Visitor visitor) const {
+    if (root_) {
+      ForEachChunk(root_, visitor);
+    }
+  }
+};
+
+Rope::Rope(const String& string) : root_() {
+  if (!string.empty()) {
+    root_ = std::make_shared<const Node>(std::make_shared<const String>(string), 0, string.size());
+  }
+}
+
+Rope::NodePtr Rope::Slice(const NodePtr& leaf, size_t begin, size_t end) {
+  if (begin >= end) {
+    return nullptr;
+  }
+  if (begin == 0 && end == leaf->size) {
+    return leaf;
+  }
+  return std::make_shared<const Node>(leaf->buffer, leaf->offset + begin, end - begin);
+}
+
+Rope::NodePtr Rope::MergeLeaves(const NodePtr& left, const NodePtr& right) {
+  String merged(left->size + right->size, '\0');
+  std::copy(left->Chars(), left->Chars() + left->size, merged.data());
+  std::copy(right->Chars(), right->Chars() + right->size, merged.data() + left->size);
+  return std::make_shared<const Node>(std::make_shared<const String>(std::move(merged)), 0,
+                                      left->size + right->size);
+}
+
+// Replaces the last leaf of node by its merge with leaf, or returns null if
+// the result would exceed kMergeLimit. Heights do not change.
+Rope::NodePtr Rope::AbsorbRight(const NodePtr& node, const NodePtr& leaf) {
+  if (node->IsLeaf()) {
+    return node->size + leaf->size <= kMergeLimit ? MergeLeaves(node, leaf) : nullptr;
+  }
+  NodePtr right = AbsorbRight(node->right, leaf);
+  return right ? MakeNode(node->left, right) : nullptr;
+}
+
+Rope::NodePtr Rope::AbsorbLeft(const NodePtr& leaf, const NodePtr& node) {
+  if (node->IsLeaf()) {
+    return node->size + leaf->size <= kMergeLimit ? MergeLeaves(leaf, node) : nullptr;
+  }
+  NodePtr left = AbsorbLeft(leaf, node->left);
+  return left ? MakeNode(left, node->right) : nullptr;
+}
+
+// (a, (b, c)) -> ((a, b), c)
+Rope::NodePtr Rope::RotateLeft(const NodePtr& node) {
+  const NodePtr& right = node->right;
+  return MakeNode(MakeNode(node->left, right->left), right->right);
+}
+
+// ((a, b), c) -> (a, (b, c))
+Rope::NodePtr Rope::RotateRight(const NodePtr& node) {
+  const NodePtr& left = node->left;
+  return MakeNode(left->left, MakeNode(left->right, node->right));
+}
+
+// Join of AVL trees when left is at least two levels taller: walk down its
+// right spine to a subtree of about right's height and rebalance on the way
+// back, as in Blelloch, Ferizovic and Sun, "Just Join for Parallel Ordered
+// Sets".
+Rope::NodePtr Rope::JoinRight(const NodePtr& left, const NodePtr& right) {
+  const NodePtr& outer = left->left;
+  const NodePtr& inner = left->right;
+  if (inner->height <= right->height + 1) {
+    NodePtr joined = MakeNode(inner, right);
+    if (joined->height <= outer->height + 1) {
+      return MakeNode(outer, joined);
+    }
+    return RotateLeft(MakeNode(outer, RotateRight(joined)));
+  }
+  NodePtr joined = JoinRight(inner, right);
+  NodePtr result = MakeNode(outer, joined);
+  return joined->height <= outer->height + 1 ? result : RotateLeft(result);
+}
+
+Rope::NodePtr Rope::JoinLeft(const NodePtr& left, const NodePtr& right) {
+  const NodePtr& outer = right->right;
+  const NodePtr& inner = right->left;
+  if (inner->height <= left->height + 1) {
+    NodePtr joined = MakeNode(left, inner);
+    if (joined->height <= outer->height + 1) {
+      return MakeNode(joined, outer);
+    }
+    return RotateRight(MakeNode(RotateLeft(joined), outer));
+  }
+  NodePtr joined = JoinLeft(left, inner);
+  NodePtr result = MakeNode(joined, outer);
+  return joined->height <= outer->height + 1 ? result : RotateRight(result);
+}
+
+Rope::NodePtr Rope::Join(const NodePtr& left, const NodePtr& right) {
+  if (!left) {
+    return right;
+  }
+  if (!right) {
+    return left;
+  }
+  if (right->IsLeaf() && right->size < kMergeLimit) {
+    if (NodePtr absorbed = AbsorbRight(left, right)) {
+      return absorbed;
+    }
+  }
+  if (left->IsLeaf() && left->size < kMergeLimit) {
+    if (NodePtr absorbed = AbsorbLeft(left, right)) {
+      return absorbed;
+    }
+  }
+  if (left->height > right->height + 1) {
+    return JoinRight(left, right);
+  }
+  if (right->height > left->height + 1) {
+    return JoinLeft(left, right);
+  }
+  return MakeNode(left, right);
+}
+
+// Every level joins at most one piece onto the result, and the heights of
+// the pieces telescope, so the whole split is O(log n).
+std::pair<Rope::NodePtr, Rope::NodePtr> Rope::Split(const NodePtr& node, size_t index) {
+  if (node->IsLeaf()) {
+    return {Slice(node, 0, index), Slice(node, index, node->size)};
+  }
+  size_t left_size = node->left->size;
+  if (index == left_size) {
+    return {node->left, node->right};
+  }
+  if (index < left_size) {
+    std::pair<NodePtr, NodePtr> parts = Split(node->left, index);
+    return {parts.first, Join(parts.second, node->right)};
+  }
+  std::pair<NodePtr, NodePtr> parts = Split(node->right, index - left_size);
+  return {Join(node->left, parts.first), parts.second};
+}
+
+template <typename Visitor>
+void Rope::ForEachChunk(const NodePtr& node, Visitor& visitor) {
+  if (node->IsLeaf()) {
+    visitor(node->Chars(), node->size);
+    return;
+  }
+  ForEachChunk(node->left, visitor);
+  ForEachChunk(node->right, visitor);
+}
+
+char Rope::operator[](size_t index) const {
+  const Node* node = root_.get();
+  while (!node->IsLeaf()) {
+    if (index < node->left->size) {
+      node = node->left.get();
+    } else {
+      index -= node->left->size;
+      node = node->right.get();
+    }
+  }
+  return node->Chars()[index];
+}
+
+Rope& Rope::operator+=(const Rope& other) {
+  root_ = Join(root_, other.root_);
+  return *this;
+}
+
+std::pair<Rope, Rope> Rope::split(size_t index) const {
+  if (index >= size()) {
+    return {*this, Rope()};
+  }
+  if (index == 0) {
+    return {Rope(), *this};
+  }
+  std::pair<NodePtr, NodePtr> parts = Split(root_, index);
+  return {Rope(parts.first), Rope(parts.second)};
+}
+
+Rope Rope::substr(size_t start, size_t count) const {
+  return split(start).second.split(count).first;
+}
+
+Rope Rope::insert(size_t index, const Rope& other) const {
+  std::pair<Rope, Rope> parts = split(index);
+  return Rope(Join(Join(parts.first.root_, other.root_), parts.second.root_));
+}
+
+Rope Rope::erase(size_t start, size_t count) const {
+  std::pair<Rope, Rope> head = split(start);
+  return Rope(Join(head.first.root_, head.second.split(count).second.root_));
+}
+
+String Rope::flatten() const {
+  String result(size(), '\0');
+  char* out = result.data();
+  forEachChunk([&out](const char* chars, size_t count) {
+    out = std::copy(chars, chars + count, out);
+  });
+  return result;
+}
+
+Rope operator+(const Rope& a, const Rope& b) {
+  Rope result = a;
+  result += b;
+  return result;
+}
+
+std::ostream& operator<<(std::ostream& out, const Rope& rope) {
+  rope.forEachChunk([&out](const char* chars, size_t count) {
+    out.write(chars, static_cast<std::streamsize>(count));
+  });
+  return out;
+}
@@ -1,36 +1,68 @@
 #pragma once
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 
+#include "string_search.h"
+#include "string_view.h"
+
 class String {
+  // Strings of up to kLocalCapacity chars live in local_, inside the object,
+  // and never touch the heap. Longer ones own a heap buffer of capacity_ + 1
+  // chars, which overlays local_.
+  static constexpr size_t kLocalCapacity = 22;
+
   explicit String(const size_t count, const bool make_empty)
-    : str_(new char[count + 1])
-    , size_(count)
-    , capacity_(count + 1) {
-    if (make_empty) {
-      size_ = 0;
+    : str_(local_)
+    , size_(make_empty ? 0 : count)
+    , local_() {
+    if (count > kLocalCapacity) {
+      str_ = new char[count + 1];
+      capacity_ = count;
+    }
+    str_[size_] = '\0';
+  }
+
+  bool IsLocal() const {
+    return str_ == local_;
+  }
+
+  void Release() {
+    if (!IsLocal()) {
+      delete[] str_;
     }
   }
 
-  void IncreaseCapacity();
+  void Reallocate(size_t new_capacity);
 
-  char* str_ = new char[1];
-  size_t size_ = 0;
-  size_t capacity_ = 1;
+  void Append(const char* str, size_t count);
+
+  char* str_;
+  size_t size_;
+  union {
+    size_t capacity_;
+    char local_[kLocalCapacity + 1];
+  };
 
 public:
   String(const char* str);
 
   String(size_t count, char c);
 
-  String() = default;
+  String() : str_(local_), size_(0), local_() {}
 
   String(const String& other);
 
+  String(String&& other) noexcept;
+
+  explicit String(StringView view);
+
   explicit String(size_t count);
 
   String& operator=(const String& other);
 
+  String& operator=(String&& other) noexcept;
+
   ~String();
 
   const char& operator[](const size_t index) const {
@@ -50,9 +82,17 @@ public:
   }
 
   size_t capacity() const {
-    return capacity_ - 1;
+    return IsLocal() ? kLocalCapacity : capacity_;
   }
 
+  void reserve(size_t new_capacity);
+
+  // Makes room for count chars and lets operation(data(), count) write them
+  // without filling them first, as std::string::resize_and_overwrite does.
+  // operation returns the final size, at most count.
+  template <typename Operation>
+  void resize_and_overwrite(size_t count, Operation operation);
+
   void push_back(char c);
 
   void pop_back();
@@ -79,6 +119,11 @@ public:
 
   String& operator+=(const char* str);
 
+  String& append(const char* str, size_t count) {
+    Append(str, count);
+    return *this;
+  }
+
   size_t find(const String& substring) const;
 
   size_t rfind(const String& substring) const;
@@ -100,28 +145,48 @@ public:
   char* data() {
     return str_;
   }
+
+  operator StringView() const {
+    return StringView(str_, size_);
+  }
 };
 
-void String::IncreaseCapacity() {
-  size_t new_capacity_ = capacity_ * 2 + 1;
-  char* new_str = new char[new_capacity_];
+// Keeps the contents; new_capacity must be above kLocalCapacity.
+void String::Reallocate(size_t new_capacity) {
+  char* new_str = new char[new_capacity + 1];
   std::copy(str_, str_ + size_ + 1, new_str);
-
-  delete[] str_;
+  Release();
   str_ = new_str;
+  capacity_ = new_capacity;
+}
+
+// Grows geometrically, so a run of appends is amortized O(1) per char. str
+// may point into this string itself: the old buffer is released only after
+// the copy.
+void String::Append(const char* str, size_t count) {
+  if (size_ + count > capacity()) {
+    size_t new_capacity = std::max(size_ + count, 2 * capacity());
+    char* new_str = new char[new_capacity + 1];
+    std::copy(str_, str_ + size_, new_str);
+    std::copy(str, str + count, new_str + size_);
+    Release();
+    str_ = new_str;
+    capacity_ = new_capacity;
+  } else {
+    std::copy(str, str + count, str_ + size_);
+  }
+  size_ += count;
   str_[size_] = '\0';
-  capacity_ = new_capacity_;
 }
 
 String::String(const char* str)
     : String(strlen(str), false) {
-  std::copy(str, str + capacity_, str_);
+  std::copy(str, str + size_ + 1, str_);
 }
 
 String::String(const size_t count, char c)
   : String(count, false) {
-  memset(str_, c, count + 1);
-  str_[size_] = '\0';
+  std::fill(str_, str_ + count, c);
 }
 
 String::String(const String& other)
@@ -129,15 +194,36 @@ String::String(const String& other)
   std::copy(other.str_, other.str_ + other.size_ + 1, str_);
 }
 
+String::String(String&& other) noexcept
+  : str_(local_)
+  , size_(other.size_)
+  , local_() {
+  if (other.IsLocal()) {
+    std::copy(other.local_, other.local_ + other.size_ + 1, local_);
+  } else {
+    str_ = other.str_;
+    capacity_ = other.capacity_;
+    other.str_ = other.local_;
+  }
+  other.size_ = 0;
+  other.str_[0] = '\0';
+}
+
+String::String(StringView view)
+  : String(view.size(), false) {
+  std::copy(view.begin(), view.end(), str_);
+}
+
 String::String(size_t count)
   : String(count, true) {}
 
 String& String::operator=(const String& other) {
   if (this != &other) {
-    if (capacity_ <= other.size_) {
-      delete[] str_;
-      str_ = new char[other.capacity_];
-      capacity_ = other.capacity_;
+    if (capacity() < other.size_) {
+      char* new_str = new char[other.size_ + 1];
+      Release();
+      str_ = new_str;
+      capacity_ = other.size_;
     }
     size_ = other.size_;
     std::copy(other.str_, other.str_ + other.size_ + 1, str_);
@@ -145,13 +231,44 @@ String& String::operator=(const String& other) {
   return *this;
 }
 
+String& String::operator=(String&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  if (other.IsLocal()) {
+    std::copy(other.local_, other.local_ + other.size_ + 1, str_);
+  } else {
+    Release();
+    str_ = other.str_;
+    capacity_ = other.capacity_;
+    other.str_ = other.local_;
+  }
+  size_ = other.size_;
+  other.size_ = 0;
+  other.str_[0] = '\0';
+  return *this;
+}
+
 String::~String() {
-  delete[] str_;
+  Release();
+}
+
+void String::reserve(size_t new_capacity) {
+  if (new_capacity > capacity()) {
+    Reallocate(new_capacity);
+  }
+}
+
+template <typename Operation>
+void String::resize_and_overwrite(size_t count, Operation operation) {
+  reserve(count);
+  size_ = operation(str_, count);
+  str_[size_] = '\0';
 }
 
 void String::push_back(char c) {
-  if (size_ >= capacity_ - 1) {
-    IncreaseCapacity();
+  if (size_ == capacity()) {
+    Reallocate(2 * capacity());
   }
   str_[size_] = c;
   ++size_;
@@ -166,14 +283,7 @@ void String::pop_back() {
 }
 
 String& String::operator+=(const String& other) {
-  const size_t kNewSize = size_ + other.size_;
-  if (kNewSize >= capacity_ - 1) {
-    capacity_ = kNewSize / 2;
-    IncreaseCapacity();
-  }
-  std::copy(other.str_, other.str_ + other.size_ + 1, str_ + size_);
-  size_ = kNewSize;
-
+  Append(other.str_, other.size_);
   return *this;
 }
 
@@ -183,33 +293,16 @@ String& String::operator+=(char c) {
 }
 
 String& String::operator+=(const char* str) {
-  std::copy(str, str + strlen(str) + 1, str_ + size_);
-  size_ += strlen(str);
+  Append(str, strlen(str));
   return *this;
 }
 
 size_t String::find(const String& substring) const {
-  if (substring.size() > size()) {
-    return length();
-  }
-  for (size_t i = 0; i <= size_ - substring.size_; ++i) {
-    if (memcmp(str_ + i, substring.str_, substring.size_) == 0) {
-      return i;
-    }
-  }
-  return length();
+  return FindSubstring(str_, size_, substring.str_, substring.size_);
 }
 
 size_t String::rfind(const String& substring) const {
-  if (substring.size() > size()) {
-    return length();
-  }
-  for (size_t i = size_ - substring.size_ + 1; i--;)  {
-    if (memcmp(str_ + i, substring.str_, substring.size_) == 0) {
-      return i;
-    }
-  }
-  return length();
+  return RfindSubstring(str_, size_, substring.str_, substring.size_);
 }
 
 String String::substr(size_t start, size_t count) const {
@@ -228,14 +321,21 @@ void String::clear() {
 }
 
 void String::shrink_to_fit() {
-  if (size_ + 1 != capacity_) {
-    capacity_ = size_ / 2;
-    IncreaseCapacity();
+  if (IsLocal() || size_ == capacity_) {
+    return;
   }
+  if (size_ > kLocalCapacity) {
+    Reallocate(size_);
+    return;
+  }
+  char* old_str = str_;
+  std::copy(old_str, old_str + size_ + 1, local_);
+  str_ = local_;
+  delete[] old_str;
 }
 
 bool operator==(const String& a, const String& b) {
-  return memcmp(a.data(), b.data(), std::min(a.size(), b.size())) == 0;
+  return a.size() == b.size() && EqualBytes(a.data(), b.data(), a.size());
 }
 
 bool operator!=(const String& a, const String& b) {
@@ -243,20 +343,19 @@ bool operator!=(const String& a, const String& b) {
 }
 
 bool operator<(const String& a, const String& b) {
-  return memcmp(a.data(), b.data(), std::min(a.size(), b.size())) > 0;
+  return Compare(a, b) < 0;
 }
 
 bool operator<=(const String& a, const String& b) {
-  return a < b || a == b;
+  return Compare(a, b) <= 0;
 }
 
 bool operator>(const String& a, const String& b) {
-  return !(a <= b);
+  return Compare(a, b) > 0;
 }
 
-
 bool operator>=(const String& a, const String& b) {
-  return !(a < b);
+  return Compare(a, b) >= 0;
 }
 
 String operator+(const String& str, char c) {
@@ -295,19 +394,110 @@ String operator+(const String& str1, const char* str2) {
 }
 
 std::ostream& operator<<(std::ostream& out, const String& string) {
-  for (size_t i = 0; i < string.size(); ++i) {
-    out << string[i];
+  return out.write(string.data(), static_cast<std::streamsize>(string.size()));
+}
+
+namespace detail {
+
+// Pulls chars from the stream buffer until stop(c) or end of input and
+// appends them in chunks, so the String grows once per chunk rather than
+// once per char. sbumpc() is an inline pointer bump while the buffer has
+// data. Returns the number of chars consumed, the stopping one included.
+template <typename Stop>
+size_t ReadUntil(std::istream& in, String& string, size_t limit, bool consume_stop, Stop stop) {
+  constexpr size_t kChunk = 256;
+  char chunk[kChunk];
+  size_t filled = 0;
+  size_t consumed = 0;
+  std::streambuf* buffer = in.rdbuf();
+  std::ios_base::iostate state = std::ios_base::goodbit;
+  // The limit is checked before peeking: once it is reached the stream is
+  // left alone, so no eofbit and no blocking read on an interactive input.
+  while (consumed < limit) {
+    int c = buffer->sgetc();
+    if (std::char_traits<char>::eq_int_type(c, std::char_traits<char>::eof())) {
+      state |= std::ios_base::eofbit;
+      break;
+    }
+    char symbol = std::char_traits<char>::to_char_type(c);
+    if (stop(symbol)) {
+      if (consume_stop) {
+        buffer->sbumpc();
+        ++consumed;
+      }
+      break;
+    }
+    chunk[filled++] = symbol;
+    ++consumed;
+    buffer->sbumpc();
+    if (filled == kChunk) {
+      string.append(chunk, filled);
+      filled = 0;
+    }
   }
-  return out;
+  string.append(chunk, filled);
+  if (state != std::ios_base::goodbit) {
+    in.setstate(state);
+  }
+  return consumed;
 }
 
+}  // namespace detail
+
+// Skips leading whitespace, then reads up to the next whitespace char (left
+// in the stream) or in.width() chars, like operator>> for std::string.
+// Whitespace is that of the "C" locale, as std::isspace had it before.
 std::istream& operator>>(std::istream& in, String& string) {
+  std::istream::sentry sentry(in);
+  if (!sentry) {
+    return in;
+  }
   string.clear();
-  char symbol;
-  in.get(symbol);
-  while (!in.eof() && !std::isspace(symbol)) {
-    string.push_back(symbol);
-    symbol = static_cast<char>(in.get());
+  std::streamsize width = in.width();
+  size_t limit = width > 0 ? static_cast<size_t>(width) : static_cast<size_t>(-1);
+  size_t consumed = detail::ReadUntil(in, string, limit, false, detail::IsSpace);
+  in.width(0);
+  if (consumed == 0) {
+    in.setstate(std::ios_base::failbit);
   }
   return in;
 }
+
+// Reads a line up to delimiter, which is consumed but not stored.
+std::istream& getline(std::istream& in, String& string, char delimiter = '\n') {
+  std::istream::sentry sentry(in, true);
+  if (!sentry) {
+    return in;
+  }
+  string.clear();
+  size_t consumed = detail::ReadUntil(in, string, static_cast<size_t>(-1), true, [delimiter](char c) {
+    return c == delimiter;
+  });
+  if (consumed == 0) {
+    in.setstate(std::ios_base::failbit);
+  }
+  return in;
+}
+
+String ToLower(StringView view) {
+  String result(view);
+  AsciiToLower(result.data(), result.size());
+  return result;
+}
+
+String ToUpper(StringView view) {
+  String result(view);
+  AsciiToUpper(result.data(), result.size());
+  return result;
+}
+
+namespace std {
+
+template <>
+struct hash<String> {
+  size_t operator()(const String& str) const {
+    return HashBytes(str.data(), str.size());
+  }
+};
+
+}  // namespace std
@@ -0,0 +1,238 @@
+#pragma once
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <type_traits>
+#include <vector>
+
+#include "string.h"
+
+/*
+ * Building a String from many parts in one allocation. Every part becomes a
+ * Piece first: strings are referenced, not copied, and numbers are rendered
+ * with std::to_chars into a few bytes inside the Piece. Once all pieces are
+ * known the total length is too, so the result is allocated once at its
+ * final size and the pieces are copied into it.
+ *
+ * Referenced chars must stay alive until the String is built, as for
+ * StringView.
+ */
+
+namespace detail {
+
+class Piece {
+  // Enough for any integer and for the shortest form of any floating point
+  // number to_chars produces, long double included.
+  static constexpr size_t kNumberChars = 32;
+
+  // Null when the chars are in local_.
+  const char* external_;
+  size_t size_;
+  char local_[kNumberChars];
+
+public:
+  Piece(StringView view) : external_(view.data()), size_(view.size()), local_() {}
+
+  // Without it a C string would rather convert to bool than to StringView.
+  Piece(const char* str) : Piece(StringView(str)) {}
+
+  Piece(char c) : external_(nullptr), size_(1), local_() {
+    local_[0] = c;
+  }
+
+  template <typename Number, typename = std::enable_if_t<std::is_arithmetic_v<Number>>>
+  Piece(Number value) : external_(nullptr), size_(0), local_() {
+    if constexpr (std::is_same_v<Number, bool>) {
+      external_ = value ? "true" : "false";
+      size_ = value ? 4 : 5;
+    } else {
+      std::to_chars_result result = std::to_chars(local_, local_ + kNumberChars, value);
+      assert(result.ec == std::errc());
+      size_ = static_cast<size_t>(result.ptr - local_);
+    }
+  }
+
+  const char* data() const {
+    return external_ != nullptr ? external_ : local_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+};
+
+}  // namespace detail
+
+/*
+ * Accumulates parts with append() or <<, then renders them all at once:
+ *
+ *   StringBuilder builder;
+ *   builder << "id:" << key << '#' << 42 << ' ' << 0.5;
+ *   String line = builder.build();
+ *
+ * The builder can be cleared and reused; its piece list keeps its capacity.
+ */
+class StringBuilder {
+  std::vector<detail::Piece> pieces_;
+  size_t size_;
+
+public:
+  StringBuilder() : pieces_(), size_(0) {}
+
+  template <typename Part>
+  StringBuilder& append(const Part& part) {
+    pieces_.emplace_back(part);
+    size_ += pieces_.back().size();
+    return *this;
+  }
+
+  template <typename Part>
+  StringBuilder& operator<<(const Part& part) {
+    return append(part);
+  }
+
+  // Length of the String build() would return.
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  void reserve(size_t piece_count) {
+    pieces_.reserve(piece_count);
+  }
+
+  void clear() {
+    pieces_.clear();
+    size_ = 0;
+  }
+
+  // Appends the parts to string, growing it at most once.
+  void appendTo(String& string) const;
+
+  String build() const;
+};
+
+void StringBuilder::appendTo(String& string) const {
+  string.reserve(string.size() + size_);
+  for (const detail::Piece& piece : pieces_) {
+    string.append(piece.data(), piece.size());
+  }
+}
+
+String StringBuilder::build() const {
+  String result(size_);
+  appendTo(result);
+  return result;
+}
+
+// Concatenation of all parts in one allocation: Concat("a", s, 'c', t)
+// instead of "a" + s + 'c' + t, which makes a temporary per +.
+template <typename... Parts>
+String Concat(const Parts&... parts) {
+  const std::array<detail::Piece, sizeof...(Parts)> pieces = {detail::Piece(parts)...};
+  size_t size = 0;
+  for (const detail::Piece& piece : pieces) {
+    size += piece.size();
+  }
+  String result(size);
+  for (const detail::Piece& piece : pieces) {
+    result.append(piece.data(), piece.size());
+  }
+  return result;
+}
+
+namespace detail {
+
+// Number of {} placeholders in format, or -1 if it has a brace that is
+// neither part of {} nor doubled as {{ or }}.
+constexpr int CountPlaceholders(const char* format) {
+  int count = 0;
+  for (size_t i = 0; format[i] != '\0'; ++i) {
+    if (format[i] == '{') {
+      if (format[i + 1] == '}') {
+        ++count;
+      } else if (format[i + 1] != '{') {
+        return -1;
+      }
+      ++i;
+    } else if (format[i] == '}') {
+      if (format[i + 1] != '}') {
+        return -1;
+      }
+      ++i;
+    }
+  }
+  return count;
+}
+
+// Chars format contributes by itself: everything but the placeholders, with
+// doubled braces counted once.
+constexpr size_t FormatTextSize(const char* format) {
+  size_t size = 0;
+  for (size_t i = 0; format[i] != '\0'; ++i) {
+    if (format[i] == '{' && format[i + 1] == '}') {
+      ++i;
+      continue;
+    }
+    if (format[i] == '{' || format[i] == '}') {
+      ++i;
+    }
+    ++size;
+  }
+  return size;
+}
+
+}  // namespace detail
+
+/*
+ * Formats args into format, replacing each {} by the next argument; {{ and
+ * }} stand for literal braces. Called through STRING_FORMAT, which hands the
+ * format literal over as a lambda so that it stays a constant expression:
+ * a malformed format or a wrong number of arguments fails to compile.
+ *
+ *   String line = STRING_FORMAT("{}: {} of {}", name, done, total);
+ *
+ * The length of the result is known before anything is written, so it is
+ * rendered straight into a String allocated once.
+ */
+template <typename Literal, typename... Args>
+String FormatLiteral(Literal literal, const Args&... args) {
+  constexpr const char* format = literal();
+  constexpr int placeholders = detail::CountPlaceholders(format);
+  static_assert(placeholders >= 0, "format has an unmatched brace");
+  static_assert(static_cast<size_t>(placeholders) == sizeof...(Args),
+                "format placeholders do not match the arguments");
+  constexpr size_t text_size = detail::FormatTextSize(format);
+
+  const std::array<detail::Piece, sizeof...(Args)> pieces = {detail::Piece(args)...};
+  size_t size = text_size;
+  for (const detail::Piece& piece : pieces) {
+    size += piece.size();
+  }
+  String result(size);
+  size_t next = 0;
+  size_t start = 0;
+  size_t i = 0;
+  for (; format[i] != '\0'; ++i) {
+    if (format[i] != '{' && format[i] != '}') {
+      continue;
+    }
+    result.append(format + start, i - start);
+    if (format[i] == '{' && format[i + 1] == '}') {
+      result.append(pieces[next].data(), pieces[next].size());
+      ++next;
+      start = i + 2;
+    } else {
+      // A doubled brace: keep the second one as text.
+      start = i + 1;
+    }
+    ++i;
+  }
+  result.append(format + start, i - start);
+  return result;
+}
+
+#define STRING_FORMAT(format, ...) FormatLiteral([] { return format; }, ##__VA_ARGS__)
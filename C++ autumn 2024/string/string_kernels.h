@@ -0,0 +1,297 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Byte kernels behind String and StringView: comparison, hashing, ASCII case
+ * conversion and whitespace skipping. The vector paths take 32 bytes per
+ * step, as one AVX2 register or as two SSE2 ones, and the scalar loops only
+ * finish the tail, so results never depend on which path ran.
+ */
+
+namespace detail {
+
+#if defined(__AVX2__)
+using Block = __m256i;
+
+inline Block Load(const char* data) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+}
+
+inline void Store(char* data, Block block) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), block);
+}
+
+inline Block Splat(char c) {
+  return _mm256_set1_epi8(c);
+}
+
+inline uint32_t EqualMask(Block a, Block b) {
+  return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+}
+
+inline Block Add(Block a, Block b) {
+  return _mm256_add_epi8(a, b);
+}
+
+// 0xff in every byte where a < b as signed chars.
+inline Block LessBytes(Block a, Block b) {
+  return _mm256_cmpgt_epi8(b, a);
+}
+
+// Toggles bit 0x20 in the bytes selected by letters.
+inline Block FlipCase(Block block, Block letters) {
+  return _mm256_xor_si256(block, _mm256_and_si256(letters, Splat(0x20)));
+}
+
+constexpr size_t kBlockBytes = 32;
+#elif defined(__SSE2__)
+// Two SSE2 registers stand in for one 32-byte block.
+struct Block {
+  __m128i low;
+  __m128i high;
+};
+
+inline Block Load(const char* data) {
+  return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16))};
+}
+
+inline void Store(char* data, Block block) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(data), block.low);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(data + 16), block.high);
+}
+
+inline Block Splat(char c) {
+  return {_mm_set1_epi8(c), _mm_set1_epi8(c)};
+}
+
+inline uint32_t Mask(__m128i low, __m128i high) {
+  return static_cast<uint32_t>(_mm_movemask_epi8(low)) | (static_cast<uint32_t>(_mm_movemask_epi8(high)) << 16);
+}
+
+inline uint32_t EqualMask(Block a, Block b) {
+  return Mask(_mm_cmpeq_epi8(a.low, b.low), _mm_cmpeq_epi8(a.high, b.high));
+}
+
+inline Block Add(Block a, Block b) {
+  return {_mm_add_epi8(a.low, b.low), _mm_add_epi8(a.high, b.high)};
+}
+
+inline Block LessBytes(Block a, Block b) {
+  return {_mm_cmplt_epi8(a.low, b.low), _mm_cmplt_epi8(a.high, b.high)};
+}
+
+inline Block FlipCase(Block block, Block letters) {
+  __m128i bit = _mm_set1_epi8(0x20);
+  return {_mm_xor_si128(block.low, _mm_and_si128(letters.low, bit)),
+          _mm_xor_si128(block.high, _mm_and_si128(letters.high, bit))};
+}
+
+constexpr size_t kBlockBytes = 32;
+#endif
+
+inline int ByteDifference(char a, char b) {
+  return static_cast<int>(static_cast<unsigned char>(a)) - static_cast<int>(static_cast<unsigned char>(b));
+}
+
+}  // namespace detail
+
+// memcmp-style three-way comparison of n bytes, as unsigned chars.
+int CompareBytes(const char* a, const char* b, size_t n) {
+  size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+  for (; i + detail::kBlockBytes <= n; i += detail::kBlockBytes) {
+    uint32_t differ = ~detail::EqualMask(detail::Load(a + i), detail::Load(b + i));
+    if (differ != 0) {
+      size_t k = i + static_cast<size_t>(__builtin_ctz(differ));
+      return detail::ByteDifference(a[k], b[k]);
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    if (a[i] != b[i]) {
+      return detail::ByteDifference(a[i], b[i]);
+    }
+  }
+  return 0;
+}
+
+bool EqualBytes(const char* a, const char* b, size_t n) {
+  size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+  for (; i + detail::kBlockBytes <= n; i += detail::kBlockBytes) {
+    if (detail::EqualMask(detail::Load(a + i), detail::Load(b + i)) != UINT32_MAX) {
+      return false;
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    if (a[i] != b[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+namespace detail {
+
+// Secret and mixing steps of wyhash, final version 4.
+constexpr uint64_t kHashSecret[4] = {0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL,
+                                     0x4d5a2da51de1aa47ULL};
+
+inline void MultiplyFold(uint64_t& a, uint64_t& b) {
+  __uint128_t product = static_cast<__uint128_t>(a) * b;
+  a = static_cast<uint64_t>(product);
+  b = static_cast<uint64_t>(product >> 64);
+}
+
+inline uint64_t Mix(uint64_t a, uint64_t b) {
+  MultiplyFold(a, b);
+  return a ^ b;
+}
+
+inline uint64_t Read8(const char* data) {
+  uint64_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+inline uint64_t Read4(const char* data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+inline uint64_t Read3(const char* data, size_t n) {
+  return (static_cast<uint64_t>(static_cast<unsigned char>(data[0])) << 16)
+         | (static_cast<uint64_t>(static_cast<unsigned char>(data[n >> 1])) << 8)
+         | static_cast<uint64_t>(static_cast<unsigned char>(data[n - 1]));
+}
+
+// Bit i set when byte i is ' ' or one of '\t', '\n', '\v', '\f', '\r'.
+#if defined(__AVX2__) || defined(__SSE2__)
+inline uint32_t SpaceMask(Block block) {
+  // c - 9 + 128 < 5 - 128 as signed chars exactly for c in ['\t', '\r'].
+  Block control = LessBytes(Add(block, Splat(static_cast<char>(128 - 9))), Splat(static_cast<char>(-128 + 5)));
+  uint32_t mask = EqualMask(block, Splat(' '));
+  Block zero = Splat(0);
+  return mask | ~EqualMask(control, zero);
+}
+#endif
+
+inline bool IsSpace(char c) {
+  return c == ' ' || static_cast<unsigned char>(c - '\t') < 5;
+}
+
+// Toggles the case of every byte in [first, first + 26).
+inline void FlipRange(char* data, size_t n, char first) {
+  size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+  // c - first + 128 < 26 - 128 as signed chars exactly for c in the range.
+  const Block shift = Splat(static_cast<char>(128 - first));
+  const Block limit = Splat(static_cast<char>(-128 + 26));
+  for (; i + kBlockBytes <= n; i += kBlockBytes) {
+    Block block = Load(data + i);
+    Store(data + i, FlipCase(block, LessBytes(Add(block, shift), limit)));
+  }
+#endif
+  for (; i < n; ++i) {
+    if (static_cast<unsigned char>(data[i] - first) < 26) {
+      data[i] = static_cast<char>(data[i] ^ 0x20);
+    }
+  }
+}
+
+}  // namespace detail
+
+// 64-bit wyhash of n bytes: one 64x64->128 multiplication per 16 bytes.
+// Fast and well spread, but not meant to resist deliberate collisions.
+uint64_t HashBytes(const char* data, size_t n, uint64_t seed = 0) {
+  using detail::kHashSecret;
+  seed ^= detail::Mix(seed ^ kHashSecret[0], kHashSecret[1]);
+  uint64_t a = 0;
+  uint64_t b = 0;
+  if (n <= 16) {
+    if (n >= 4) {
+      size_t step = (n >> 3) << 2;
+      a = (detail::Read4(data) << 32) | detail::Read4(data + step);
+      b = (detail::Read4(data + n - 4) << 32) | detail::Read4(data + n - 4 - step);
+    } else if (n > 0) {
+      a = detail::Read3(data, n);
+    }
+  } else {
+    size_t rest = n;
+    const char* p = data;
+    if (rest > 48) {
+      uint64_t seed1 = seed;
+      uint64_t seed2 = seed;
+      do {
+        seed = detail::Mix(detail::Read8(p) ^ kHashSecret[1], detail::Read8(p + 8) ^ seed);
+        seed1 = detail::Mix(detail::Read8(p + 16) ^ kHashSecret[2], detail::Read8(p + 24) ^ seed1);
+        seed2 = detail::Mix(detail::Read8(p + 32) ^ kHashSecret[3], detail::Read8(p + 40) ^ seed2);
+        p += 48;
+        rest -= 48;
+      } while (rest > 48);
+      seed ^= seed1 ^ seed2;
+    }
+    while (rest > 16) {
+      seed = detail::Mix(detail::Read8(p) ^ kHashSecret[1], detail::Read8(p + 8) ^ seed);
+      p += 16;
+      rest -= 16;
+    }
+    a = detail::Read8(p + rest - 16);
+    b = detail::Read8(p + rest - 8);
+  }
+  a ^= kHashSecret[1];
+  b ^= seed;
+  detail::MultiplyFold(a, b);
+  return detail::Mix(a ^ kHashSecret[0] ^ n, b ^ kHashSecret[1]);
+}
+
+void AsciiToLower(char* data, size_t n) {
+  detail::FlipRange(data, n, 'A');
+}
+
+void AsciiToUpper(char* data, size_t n) {
+  detail::FlipRange(data, n, 'a');
+}
+
+// Number of leading whitespace bytes.
+size_t CountLeadingSpaces(const char* data, size_t n) {
+  size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+  for (; i + detail::kBlockBytes <= n; i += detail::kBlockBytes) {
+    uint32_t other = ~detail::SpaceMask(detail::Load(data + i));
+    if (other != 0) {
+      return i + static_cast<size_t>(__builtin_ctz(other));
+    }
+  }
+#endif
+  while (i < n && detail::IsSpace(data[i])) {
+    ++i;
+  }
+  return i;
+}
+
+// Number of trailing whitespace bytes.
+size_t CountTrailingSpaces(const char* data, size_t n) {
+  size_t end = n;
+#if defined(__AVX2__) || defined(__SSE2__)
+  for (; end >= detail::kBlockBytes; end -= detail::kBlockBytes) {
+    uint32_t other = ~detail::SpaceMask(detail::Load(data + end - detail::kBlockBytes));
+    if (other != 0) {
+      return n - (end - detail::kBlockBytes + 32 - static_cast<size_t>(__builtin_clz(other)));
+    }
+  }
+#endif
+  while (end > 0 && detail::IsSpace(data[end - 1])) {
+    --end;
+  }
+  return n - end;
+}
@@ -0,0 +1,496 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Substring search over raw character ranges. All functions follow the
+ * String convention and return the text size when there is no match.
+ *
+ * Needles of up to kShortNeedle chars go through a SIMD filter that compares
+ * the first and the last needle byte against 16 (SSE2) or 32 (AVX2)
+ * positions at once and runs memcmp only on the candidates. Longer needles
+ * use Crochemore and Perrin's Two-Way algorithm: linear time in the worst
+ * case, constant extra space, and its table is three numbers, so it costs
+ * nothing to build per call. rfind runs the same algorithms on the reversed
+ * text and needle.
+ */
+
+namespace detail {
+
+constexpr size_t kShortNeedle = 32;
+
+// Leftmost needle occurrence starting at or after from; 1 <= m.
+inline size_t FilterFind(const char* text, size_t n, const char* needle, size_t m, size_t from) {
+  if (m > n) {
+    return n;
+  }
+  size_t i = from;
+  auto matches = [&](size_t position) {
+    return m <= 2 || memcmp(text + position + 1, needle + 1, m - 2) == 0;
+  };
+#if defined(__AVX2__)
+  const __m256i first = _mm256_set1_epi8(needle[0]);
+  const __m256i last = _mm256_set1_epi8(needle[m - 1]);
+  for (; i + m - 1 + 32 <= n; i += 32) {
+    __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+    __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + m - 1));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last))));
+    for (; mask != 0; mask &= mask - 1) {
+      size_t position = i + static_cast<size_t>(__builtin_ctz(mask));
+      if (matches(position)) {
+        return position;
+      }
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i last = _mm_set1_epi8(needle[m - 1]);
+  for (; i + m - 1 + 16 <= n; i += 16) {
+    __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+    __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + m - 1));
+    uint32_t mask = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))));
+    for (; mask != 0; mask &= mask - 1) {
+      size_t position = i + static_cast<size_t>(__builtin_ctz(mask));
+      if (matches(position)) {
+        return position;
+      }
+    }
+  }
+#endif
+  for (; i + m <= n; ++i) {
+    if (text[i] == needle[0] && text[i + m - 1] == needle[m - 1] && matches(i)) {
+      return i;
+    }
+  }
+  return n;
+}
+
+// Rightmost needle occurrence; 1 <= m.
+inline size_t FilterRfind(const char* text, size_t n, const char* needle, size_t m) {
+  if (m > n) {
+    return n;
+  }
+  // Candidates [0, end) are still to be checked.
+  size_t end = n - m + 1;
+  auto matches = [&](size_t position) {
+    return m <= 2 || memcmp(text + position + 1, needle + 1, m - 2) == 0;
+  };
+#if defined(__AVX2__)
+  const __m256i first = _mm256_set1_epi8(needle[0]);
+  const __m256i last = _mm256_set1_epi8(needle[m - 1]);
+  for (; end >= 32; end -= 32) {
+    size_t i = end - 32;
+    __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+    __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + m - 1));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last))));
+    while (mask != 0) {
+      unsigned bit = 31 - static_cast<unsigned>(__builtin_clz(mask));
+      if (matches(i + bit)) {
+        return i + bit;
+      }
+      mask ^= 1u << bit;
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i last = _mm_set1_epi8(needle[m - 1]);
+  for (; end >= 16; end -= 16) {
+    size_t i = end - 16;
+    __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+    __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + m - 1));
+    uint32_t mask = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))));
+    while (mask != 0) {
+      unsigned bit = 31 - static_cast<unsigned>(__builtin_clz(mask));
+      if (matches(i + bit)) {
+        return i + bit;
+      }
+      mask ^= 1u << bit;
+    }
+  }
+#endif
+  while (end-- > 0) {
+    if (text[end] == needle[0] && text[end + m - 1] == needle[m - 1] && matches(end)) {
+      return end;
+    }
+  }
+  return n;
+}
+
+// Char accessors, so that the Two-Way code runs over reversed ranges too.
+struct ForwardChars {
+  const char* data;
+
+  unsigned char operator[](ptrdiff_t index) const {
+    return static_cast<unsigned char>(data[index]);
+  }
+};
+
+struct BackwardChars {
+  const char* end;
+
+  unsigned char operator[](ptrdiff_t index) const {
+    return static_cast<unsigned char>(end[-1 - index]);
+  }
+};
+
+// Critical factorization of a needle: needle = u v with |u| = critical + 1,
+// and its period; periodic when u is a suffix of v's period prefix.
+struct TwoWayTable {
+  ptrdiff_t critical;
+  ptrdiff_t period;
+  bool periodic;
+};
+
+// Start (minus one) and period of the maximal suffix for the byte order, or
+// for the reversed order when inverted.
+template <typename Chars>
+ptrdiff_t MaximalSuffix(Chars needle, ptrdiff_t m, bool inverted, ptrdiff_t& period) {
+  ptrdiff_t suffix = -1;
+  ptrdiff_t j = 0;
+  ptrdiff_t k = 1;
+  period = 1;
+  while (j + k < m) {
+    unsigned char a = needle[j + k];
+    unsigned char b = needle[suffix + k];
+    if (a == b) {
+      if (k == period) {
+        j += period;
+        k = 1;
+      } else {
+        ++k;
+      }
+    } else if ((a < b) != inverted) {
+      j += k;
+      k = 1;
+      period = j - suffix;
+    } else {
+      suffix = j;
+      j = suffix + 1;
+      k = period = 1;
+    }
+  }
+  return suffix;
+}
+
+template <typename Chars>
+TwoWayTable MakeTwoWayTable(Chars needle, ptrdiff_t m) {
+  ptrdiff_t period = 1;
+  ptrdiff_t inverted_period = 1;
+  ptrdiff_t critical = MaximalSuffix(needle, m, false, period);
+  ptrdiff_t inverted_critical = MaximalSuffix(needle, m, true, inverted_period);
+  if (inverted_critical > critical) {
+    critical = inverted_critical;
+    period = inverted_period;
+  }
+  bool periodic = true;
+  for (ptrdiff_t i = 0; i <= critical && periodic; ++i) {
+    periodic = needle[i] == needle[i + period];
+  }
+  if (!periodic) {
+    period = std::max(critical + 1, m - critical - 1) + 1;
+  }
+  return {critical, period, periodic};
+}
+
+// Leftmost occurrence in text; 1 <= m. Each step either matches the right
+// half v and then the left half u of the factorization, or shifts by the
+// length of the matched prefix of v, so the scan is linear.
+template <typename Chars>
+size_t TwoWayFind(Chars text, size_t n, Chars needle, size_t m, const TwoWayTable& table) {
+  if (m > n) {
+    return n;
+  }
+  ptrdiff_t size = static_cast<ptrdiff_t>(m);
+  ptrdiff_t last = static_cast<ptrdiff_t>(n - m);
+  ptrdiff_t critical = table.critical;
+  ptrdiff_t memory = -1;
+  for (ptrdiff_t j = 0; j <= last;) {
+    ptrdiff_t i = std::max(critical, memory) + 1;
+    while (i < size && needle[i] == text[i + j]) {
+      ++i;
+    }
+    if (i < size) {
+      j += i - critical;
+      memory = -1;
+      continue;
+    }
+    i = critical;
+    ptrdiff_t stop = table.periodic ? memory : -1;
+    while (i > stop && needle[i] == text[i + j]) {
+      --i;
+    }
+    if (i <= stop) {
+      return static_cast<size_t>(j);
+    }
+    j += table.period;
+    if (table.periodic) {
+      memory = size - table.period - 1;
+    }
+  }
+  return n;
+}
+
+}  // namespace detail
+
+// Leftmost occurrence of needle[0, m) in text[from, n), or n.
+size_t FindSubstring(const char* text, size_t n, const char* needle, size_t m, size_t from = 0) {
+  if (from > n) {
+    return n;
+  }
+  if (m == 0) {
+    return from;
+  }
+  if (m == 1) {
+    const void* found = memchr(text + from, needle[0], n - from);
+    return found != nullptr ? static_cast<size_t>(static_cast<const char*>(found) - text) : n;
+  }
+  if (m <= detail::kShortNeedle) {
+    return detail::FilterFind(text, n, needle, m, from);
+  }
+  detail::ForwardChars pattern{needle};
+  detail::TwoWayTable table = detail::MakeTwoWayTable(pattern, static_cast<ptrdiff_t>(m));
+  size_t found = detail::TwoWayFind(detail::ForwardChars{text + from}, n - from, pattern, m, table);
+  return found == n - from ? n : from + found;
+}
+
+// Rightmost occurrence of needle[0, m) in text[0, n), or n.
+size_t RfindSubstring(const char* text, size_t n, const char* needle, size_t m) {
+  if (m == 0) {
+    return n;
+  }
+  if (m <= detail::kShortNeedle) {
+    return detail::FilterRfind(text, n, needle, m);
+  }
+  detail::BackwardChars pattern{needle + m};
+  detail::TwoWayTable table = detail::MakeTwoWayTable(pattern, static_cast<ptrdiff_t>(m));
+  size_t found = detail::TwoWayFind(detail::BackwardChars{text + n}, n, pattern, m, table);
+  return found == n ? n : n - found - m;
+}
+
+/*
+ * A needle prepared once for searching many texts: it keeps its own copy
+ * and both Two-Way tables. Texts are anything with data() and size(), such
+ * as String.
+ */
+class Pattern {
+  std::vector<char> needle_;
+  detail::TwoWayTable forward_;
+  detail::TwoWayTable backward_;
+
+public:
+  Pattern(const char* needle, size_t size)
+    : needle_(needle, needle + size)
+    , forward_(detail::MakeTwoWayTable(detail::ForwardChars{needle}, static_cast<ptrdiff_t>(size)))
+    , backward_(detail::MakeTwoWayTable(detail::BackwardChars{needle + size}, static_cast<ptrdiff_t>(size))) {}
+
+  template <typename Text>
+  explicit Pattern(const Text& needle) : Pattern(needle.data(), needle.size()) {}
+
+  size_t size() const {
+    return needle_.size();
+  }
+
+  size_t find(const char* text, size_t n, size_t from = 0) const;
+
+  size_t rfind(const char* text, size_t n) const;
+
+  template <typename Text>
+  size_t find(const Text& text, size_t from = 0) const {
+    return find(text.data(), text.size(), from);
+  }
+
+  template <typename Text>
+  size_t rfind(const Text& text) const {
+    return rfind(text.data(), text.size());
+  }
+};
+
+size_t Pattern::find(const char* text, size_t n, size_t from) const {
+  size_t m = needle_.size();
+  if (m <= detail::kShortNeedle || from > n) {
+    return FindSubstring(text, n, needle_.data(), m, from);
+  }
+  size_t found = detail::TwoWayFind(detail::ForwardChars{text + from}, n - from,
+                                    detail::ForwardChars{needle_.data()}, m, forward_);
+  return found == n - from ? n : from + found;
+}
+
+size_t Pattern::rfind(const char* text, size_t n) const {
+  size_t m = needle_.size();
+  if (m <= detail::kShortNeedle) {
+    return RfindSubstring(text, n, needle_.data(), m);
+  }
+  size_t found = detail::TwoWayFind(detail::BackwardChars{text + n}, n,
+                                    detail::BackwardChars{needle_.data() + m}, m, backward_);
+  return found == n ? n : n - found - m;
+}
+
+/*
+ * Aho-Corasick automaton over a set of needles, reporting every occurrence
+ * of every needle in one pass over the text. Bytes that occur in no needle
+ * share one class, so the full transition table has a column per distinct
+ * needle byte only and a text byte costs a single table lookup.
+ */
+class MultiPattern {
+public:
+  struct Match {
+    size_t position;
+    size_t needle;
+  };
+
+private:
+  static constexpr uint32_t kNone = UINT32_MAX;
+
+  std::array<uint16_t, 256> classes_;
+  size_t class_count_;
+  std::vector<uint32_t> next_;
+  std::vector<uint32_t> needle_at_;
+  std::vector<uint32_t> output_link_;
+  std::vector<uint32_t> duplicate_;
+  std::vector<size_t> lengths_;
+
+  uint32_t& Next(uint32_t state, size_t byte_class) {
+    return next_[state * class_count_ + byte_class];
+  }
+
+  void AddNeedle(const char* needle, size_t size);
+
+  void Build();
+
+public:
+  template <typename Needles>
+  explicit MultiPattern(const Needles& needles);
+
+  size_t size() const {
+    return lengths_.size();
+  }
+
+  // Calls visitor(Match) for every occurrence, ordered by end position.
+  template <typename Visitor>
+  void scan(const char* text, size_t n, Visitor visitor) const;
+
+  template <typename Text, typename Visitor>
+  void scan(const Text& text, Visitor visitor) const {
+    scan(text.data(), text.size(), visitor);
+  }
+
+  template <typename Text>
+  std::vector<Match> findAll(const Text& text) const {
+    std::vector<Match> matches;
+    scan(text, [&matches](const Match& match) { matches.push_back(match); });
+    return matches;
+  }
+
+  template <typename Text>
+  size_t count(const Text& text) const {
+    size_t total = 0;
+    scan(text, [&total](const Match&) { ++total; });
+    return total;
+  }
+};
+
+template <typename Needles>
+MultiPattern::MultiPattern(const Needles& needles)
+  : classes_()
+  , class_count_(1)
+  , next_()
+  , needle_at_()
+  , output_link_()
+  , duplicate_()
+  , lengths_() {
+  for (const auto& needle : needles) {
+    for (size_t i = 0; i < needle.size(); ++i) {
+      uint16_t& byte_class = classes_[static_cast<unsigned char>(needle.data()[i])];
+      if (byte_class == 0) {
+        byte_class = static_cast<uint16_t>(class_count_++);
+      }
+    }
+  }
+  next_.assign(class_count_, kNone);
+  needle_at_.push_back(kNone);
+  for (const auto& needle : needles) {
+    AddNeedle(needle.data(), needle.size());
+  }
+  Build();
+}
+
+void MultiPattern::AddNeedle(const char* needle, size_t size) {
+  uint32_t state = 0;
+  for (size_t i = 0; i < size; ++i) {
+    uint32_t& next = Next(state, classes_[static_cast<unsigned char>(needle[i])]);
+    if (next == kNone) {
+      next = static_cast<uint32_t>(needle_at_.size());
+      needle_at_.push_back(kNone);
+      next_.resize(next_.size() + class_count_, kNone);
+    }
+    state = Next(state, classes_[static_cast<unsigned char>(needle[i])]);
+  }
+  uint32_t index = static_cast<uint32_t>(lengths_.size());
+  lengths_.push_back(size);
+  duplicate_.push_back(needle_at_[state]);
+  needle_at_[state] = index;
+}
+
+// Breadth-first over the trie: each state's missing transitions are taken
+// from its failure state, which is already complete, turning the trie into
+// a DFA. output_link_ points to the nearest proper suffix state that ends a
+// needle.
+void MultiPattern::Build() {
+  size_t states = needle_at_.size();
+  std::vector<uint32_t> failure(states, 0);
+  output_link_.assign(states, kNone);
+  std::vector<uint32_t> queue;
+  queue.reserve(states);
+  for (size_t c = 0; c < class_count_; ++c) {
+    uint32_t& next = Next(0, c);
+    if (next == kNone) {
+      next = 0;
+    } else {
+      queue.push_back(next);
+    }
+  }
+  for (size_t head = 0; head < queue.size(); ++head) {
+    uint32_t state = queue[head];
+    uint32_t fail = failure[state];
+    output_link_[state] = needle_at_[fail] != kNone ? fail : output_link_[fail];
+    for (size_t c = 0; c < class_count_; ++c) {
+      uint32_t& next = Next(state, c);
+      if (next == kNone) {
+        next = Next(fail, c);
+      } else {
+        failure[next] = Next(fail, c);
+        queue.push_back(next);
+      }
+    }
+  }
+}
+
+template <typename Visitor>
+void MultiPattern::scan(const char* text, size_t n, Visitor visitor) const {
+  auto report = [this, &visitor](uint32_t state, size_t end) {
+    for (; state != kNone; state = output_link_[state]) {
+      for (uint32_t needle = needle_at_[state]; needle != kNone; needle = duplicate_[needle]) {
+        visitor(Match{end - lengths_[needle], needle});
+      }
+    }
+  };
+  // An empty needle ends at the root and so before every char.
+  report(0, 0);
+  uint32_t state = 0;
+  for (size_t i = 0; i < n; ++i) {
+    state = next_[state * class_count_ + classes_[static_cast<unsigned char>(text[i])]];
+    report(state, i + 1);
+  }
+}
@@ -0,0 +1,251 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "string_kernels.h"
+#include "string_search.h"
+
+/*
+ * Non-owning view of a char range: a pointer and a size, cheap to copy and
+ * never allocating. String converts to it implicitly, so every function
+ * taking a StringView accepts String, C strings and other views alike. The
+ * viewed chars must outlive the view, and a view is not null-terminated.
+ *
+ * Positions follow String: find and rfind return size() when there is no
+ * match, and substr clamps count to the end of the view.
+ */
+class StringView {
+  const char* data_;
+  size_t size_;
+
+public:
+  StringView() : data_(""), size_(0) {}
+
+  StringView(const char* str, size_t count) : data_(str), size_(count) {}
+
+  StringView(const char* str) : data_(str), size_(strlen(str)) {}
+
+  const char* data() const {
+    return data_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  size_t length() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  const char& operator[](const size_t index) const {
+    return data_[index];
+  }
+
+  const char& front() const {
+    return data_[0];
+  }
+
+  const char& back() const {
+    return data_[size_ - 1];
+  }
+
+  const char* begin() const {
+    return data_;
+  }
+
+  const char* end() const {
+    return data_ + size_;
+  }
+
+  StringView substr(size_t start, size_t count) const {
+    start = std::min(start, size_);
+    return StringView(data_ + start, std::min(count, size_ - start));
+  }
+
+  void remove_prefix(size_t count) {
+    data_ += count;
+    size_ -= count;
+  }
+
+  void remove_suffix(size_t count) {
+    size_ -= count;
+  }
+
+  bool starts_with(StringView prefix) const {
+    return prefix.size_ <= size_ && memcmp(data_, prefix.data_, prefix.size_) == 0;
+  }
+
+  bool ends_with(StringView suffix) const {
+    return suffix.size_ <= size_ && memcmp(data_ + size_ - suffix.size_, suffix.data_, suffix.size_) == 0;
+  }
+
+  size_t find(StringView substring, size_t from = 0) const {
+    return FindSubstring(data_, size_, substring.data_, substring.size_, from);
+  }
+
+  size_t find(char c, size_t from = 0) const {
+    return FindSubstring(data_, size_, &c, 1, from);
+  }
+
+  size_t rfind(StringView substring) const {
+    return RfindSubstring(data_, size_, substring.data_, substring.size_);
+  }
+
+  class SplitRange;
+
+  // Pieces between delimiters, empty ones included: "a,,b" gives "a", "",
+  // "b" and an empty view gives one empty piece.
+  SplitRange splitRange(StringView delimiter) const;
+
+  std::vector<StringView> split(StringView delimiter) const;
+};
+
+/*
+ * Lazy split: iterating yields one piece at a time, found on demand, so
+ * walking the pieces allocates nothing.
+ */
+class StringView::SplitRange {
+  StringView text_;
+  StringView delimiter_;
+
+public:
+  class Iterator {
+    StringView rest_;
+    StringView delimiter_;
+    StringView piece_;
+    bool last_;
+    bool done_;
+
+    void Advance() {
+      if (last_) {
+        done_ = true;
+        return;
+      }
+      size_t position = delimiter_.empty() ? rest_.size() : rest_.find(delimiter_);
+      piece_ = rest_.substr(0, position);
+      if (position == rest_.size()) {
+        last_ = true;
+      } else {
+        rest_.remove_prefix(position + delimiter_.size());
+      }
+    }
+
+  public:
+    Iterator() : rest_(), delimiter_(), piece_(), last_(true), done_(true) {}
+
+    Iterator(StringView text, StringView delimiter)
+      : rest_(text), delimiter_(delimiter), piece_(), last_(false), done_(false) {
+      Advance();
+    }
+
+    StringView operator*() const {
+      return piece_;
+    }
+
+    const StringView* operator->() const {
+      return &piece_;
+    }
+
+    Iterator& operator++() {
+      Advance();
+      return *this;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return done_ == other.done_ && (done_ || piece_.data() == other.piece_.data());
+    }
+
+    bool operator!=(const Iterator& other) const {
+      return !(*this == other);
+    }
+  };
+
+  SplitRange(StringView text, StringView delimiter) : text_(text), delimiter_(delimiter) {}
+
+  Iterator begin() const {
+    return Iterator(text_, delimiter_);
+  }
+
+  Iterator end() const {
+    return Iterator();
+  }
+};
+
+StringView::SplitRange StringView::splitRange(StringView delimiter) const {
+  return SplitRange(*this, delimiter);
+}
+
+std::vector<StringView> StringView::split(StringView delimiter) const {
+  std::vector<StringView> pieces;
+  for (StringView piece : splitRange(delimiter)) {
+    pieces.push_back(piece);
+  }
+  return pieces;
+}
+
+int Compare(StringView a, StringView b) {
+  int result = CompareBytes(a.data(), b.data(), std::min(a.size(), b.size()));
+  if (result != 0) {
+    return result;
+  }
+  return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+}
+
+bool operator==(StringView a, StringView b) {
+  return a.size() == b.size() && EqualBytes(a.data(), b.data(), a.size());
+}
+
+bool operator!=(StringView a, StringView b) {
+  return !(a == b);
+}
+
+bool operator<(StringView a, StringView b) {
+  return Compare(a, b) < 0;
+}
+
+bool operator<=(StringView a, StringView b) {
+  return Compare(a, b) <= 0;
+}
+
+bool operator>(StringView a, StringView b) {
+  return Compare(a, b) > 0;
+}
+
+bool operator>=(StringView a, StringView b) {
+  return Compare(a, b) >= 0;
+}
+
+std::ostream& operator<<(std::ostream& out, StringView view) {
+  return out.write(view.data(), static_cast<std::streamsize>(view.size()));
+}
+
+StringView TrimLeft(StringView view) {
+  view.remove_prefix(CountLeadingSpaces(view.data(), view.size()));
+  return view;
+}
+
+StringView TrimRight(StringView view) {
+  view.remove_suffix(CountTrailingSpaces(view.data(), view.size()));
+  return view;
+}
+
+StringView Trim(StringView view) {
+  return TrimRight(TrimLeft(view));
+}
+
+namespace std {
+
+template <>
+struct hash<StringView> {
+  size_t operator()(StringView view) const {
+    return HashBytes(view.data(), view.size());
+  }
+};
+
+}  // namespace std
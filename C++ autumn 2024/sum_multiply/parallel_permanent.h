@@ -0,0 +1,309 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "permanent.h"
+
+// The engines of permanent.h spread over threads and templated on the type
+// the sums are kept in: uint64_t for the long long answer modulo 2^64 as in
+// permanent.h, BigInteger when the answer itself may not fit, or Residue<N>
+// for the answer modulo N. Value needs +=, -=, *= and a constructor from
+// int. Every thread sums into Values or table entries of its own, which
+// are added up in thread order at the end or read in a fixed order, so the
+// result does not depend on scheduling.
+
+// Runs task(0), ..., task(threads - 1), one on the calling thread and the
+// others on threads of their own.
+template <typename Task>
+void run_threads(size_t threads, const Task& task) {
+  std::vector<std::thread> workers;
+  for (size_t thread = 1; thread < threads; thread++) {
+    workers.emplace_back([&task, thread] { task(thread); });
+  }
+  task(0);
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+// Ryser's formula as in sum_multiply_ryser, with the Gray code steps split
+// into one contiguous range per thread; a thread starts from the subset
+// before its first step, whose row sums it builds from scratch.
+template <typename Value>
+Value parallel_ryser(const int* input, int size_mas, int* const* mas, size_t threads) {
+  size_t rows = (size_t) size_mas;
+  size_t columns = (size_t) max_size(input, size_mas);
+  if (rows > columns) {
+    return Value(0);
+  }
+  std::vector<Value> binomial(rows + 1, Value(0));
+  std::vector<Value> coefficient(rows + 1, Value(0));
+  binomial[0] = Value(1);
+  for (size_t m = 0; m <= columns; m++) {
+    if (m > 0) {
+      for (size_t j = rows; j > 0; j--) {
+        binomial[j] += binomial[j - 1];
+      }
+    }
+    if (rows + m >= columns) {
+      size_t lower = rows + m - columns;
+      coefficient[columns - m] = binomial[lower];
+      if (lower % 2 == 1) {
+        coefficient[columns - m] = Value(0);
+        coefficient[columns - m] -= binomial[lower];
+      }
+    }
+  }
+
+  uint64_t subset_count = (uint64_t) 1 << columns;
+  uint64_t chunk = (subset_count - 1) / threads;
+  std::vector<Value> partial(threads, Value(0));
+  run_threads(threads, [&](size_t thread) {
+    uint64_t first = 1 + chunk * thread;
+    uint64_t last = thread == threads - 1 ? subset_count : first + chunk;
+    uint64_t subset = (first - 1) ^ ((first - 1) >> 1);
+    std::vector<Value> row_sum(rows, Value(0));
+    for (size_t column = 0; column < columns; column++) {
+      if ((subset >> column) & 1) {
+        for (size_t i = 0; i < rows; i++) {
+          if (column < (size_t) input[i]) {
+            row_sum[i] += Value(mas[i][column]);
+          }
+        }
+      }
+    }
+    size_t subset_size = (size_t) __builtin_popcountll(subset);
+    Value total(0);
+    for (uint64_t step = first; step < last; step++) {
+      size_t column = (size_t) __builtin_ctzll(step);
+      bool added = (((step ^ (step >> 1)) >> column) & 1) != 0;
+      if (added) {
+        subset_size++;
+      } else {
+        subset_size--;
+      }
+      for (size_t i = 0; i < rows; i++) {
+        if (column >= (size_t) input[i]) {
+          continue;
+        }
+        if (added) {
+          row_sum[i] += Value(mas[i][column]);
+        } else {
+          row_sum[i] -= Value(mas[i][column]);
+        }
+      }
+      if (subset_size <= rows) {
+        Value product = coefficient[subset_size];
+        for (size_t i = 0; i < rows; i++) {
+          product *= row_sum[i];
+        }
+        total += product;
+      }
+    }
+    partial[thread] = total;
+  });
+  Value total(0);
+  for (size_t thread = 0; thread < threads; thread++) {
+    total += partial[thread];
+  }
+  return total;
+}
+
+// Blocks each of count threads in wait() until all of them have got there,
+// as many times as needed.
+class Barrier {
+  std::mutex mutex_;
+  std::condition_variable all_arrived_;
+  size_t count_;
+  size_t waiting_;
+  size_t generation_;
+
+public:
+  explicit Barrier(size_t count) : mutex_(), all_arrived_(), count_(count), waiting_(0), generation_(0) {}
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    size_t generation = generation_;
+    if (++waiting_ == count_) {
+      waiting_ = 0;
+      generation_++;
+      all_arrived_.notify_all();
+      return;
+    }
+    all_arrived_.wait(lock, [this, generation] { return generation != generation_; });
+  }
+};
+
+// Bytes one entry of the partition DP tables takes, heap included, when it
+// holds sums of products of size_mas ints. Types that allocate specialise it.
+template <typename Value>
+size_t value_bytes(int size_mas) {
+  (void) size_mas;
+  return sizeof(Value);
+}
+
+// The parallel DP splits a set of rows into its part over the first
+// partitions_low_rows rows and the rest.
+const int partitions_low_rows = 10;
+
+// partitions_cost, or infinity if the two tables of 2^k Values that
+// parallel_partitions shares among all its threads pass
+// partitions_memory_budget.
+template <typename Value>
+double parallel_partitions_cost(const int* input, int size_mas) {
+  double cost = partitions_cost(input, size_mas);
+  if (cost >= infinite_cost) {
+    return cost;
+  }
+  size_t entries = (size_t) 2 << size_mas;
+  if ((double) entries * (double) value_bytes<Value>(size_mas) > (double) partitions_memory_budget) {
+    return infinite_cost;
+  }
+  return cost;
+}
+
+// The set-partition DP as in sum_multiply_partitions, on one weight and one
+// f table shared by the threads. A set of rows is a high part over the rows
+// past the first partitions_low_rows and a low part over those; each thread
+// takes a contiguous range of high parts, so it fills weights of its own,
+// and a weight is the product of the column over the high rows times the
+// one over the low rows. Those low products are doubled up as before in the
+// thread's own stretch of the f table, which is not in use yet. f is filled
+// in by the number of rows in the set, as f of a set only reads f of smaller
+// sets: every thread takes a contiguous slice of the sets of one size in
+// Gosper's hack order, and all wait for each other between sizes.
+template <typename Value>
+Value parallel_partitions(const int* input, int size_mas, int* const* mas, size_t threads) {
+  size_t rows = (size_t) size_mas;
+  size_t columns = (size_t) max_size(input, size_mas);
+  size_t subsets = (size_t) 1 << rows;
+  size_t low_rows = std::min(rows, (size_t) partitions_low_rows);
+  size_t low_count = (size_t) 1 << low_rows;
+  size_t high_count = subsets >> low_rows;
+  auto entry_value = [input, mas](size_t row, size_t column) {
+    return column < (size_t) input[row] ? Value(mas[row][column]) : Value(0);
+  };
+
+  std::vector<std::vector<uint64_t>> binomial(rows + 1, std::vector<uint64_t>(rows + 1, 0));
+  for (size_t n = 0; n <= rows; n++) {
+    binomial[n][0] = 1;
+    for (size_t m = 1; m <= n; m++) {
+      binomial[n][m] = binomial[n - 1][m - 1] + binomial[n - 1][m];
+    }
+  }
+  std::vector<Value> factorial(rows, Value(1));
+  for (size_t i = 1; i < rows; i++) {
+    factorial[i] = factorial[i - 1];
+    factorial[i] *= Value((int) i);
+  }
+
+  std::vector<Value> weight(subsets, Value(0));
+  std::vector<Value> partial(subsets, Value(0));
+  Barrier barrier(threads);
+  run_threads(threads, [&](size_t thread) {
+    size_t high_first = high_count * thread / threads;
+    size_t high_last = high_count * (thread + 1) / threads;
+    Value* low = partial.data() + (high_first << low_rows);
+    for (size_t column = 0; column < columns && high_first < high_last; column++) {
+      low[0] = Value(1);
+      for (size_t i = 0; i < low_rows; i++) {
+        size_t half = (size_t) 1 << i;
+        Value value = entry_value(i, column);
+        for (size_t set = 0; set < half; set++) {
+          low[half + set] = low[set];
+          low[half + set] *= value;
+        }
+      }
+      for (size_t high = high_first; high < high_last; high++) {
+        Value factor(1);
+        for (size_t i = low_rows; i < rows; i++) {
+          if ((high >> (i - low_rows)) & 1) {
+            factor *= entry_value(i, column);
+          }
+        }
+        size_t base = high << low_rows;
+        for (size_t set = 0; set < low_count; set++) {
+          Value term = low[set];
+          term *= factor;
+          weight[base + set] += term;
+        }
+      }
+    }
+    for (size_t set = std::max(high_first << low_rows, (size_t) 1); set < (high_last << low_rows); set++) {
+      size_t size = (size_t) __builtin_popcountll(set);
+      weight[set] *= factorial[size - 1];
+      if (size % 2 == 0) {
+        Value negated(0);
+        negated -= weight[set];
+        weight[set] = negated;
+      }
+    }
+    if (high_first == 0 && high_last > 0) {
+      partial[0] = Value(1);
+    }
+    barrier.wait();
+
+    for (size_t size = 1; size <= rows; size++) {
+      size_t count = binomial[rows][size];
+      size_t first = count * thread / threads;
+      size_t last = count * (thread + 1) / threads;
+      if (first < last) {
+        // The first-th set of this size in increasing order: bit i is set
+        // when at least C(i, left) sets of the remaining size sort below.
+        size_t set = 0;
+        size_t rank = first;
+        size_t left = size;
+        for (size_t i = rows; i-- > 0 && left > 0;) {
+          if (rank >= binomial[i][left]) {
+            rank -= binomial[i][left];
+            set |= (size_t) 1 << i;
+            left--;
+          }
+        }
+        for (size_t index = first; index < last; index++) {
+          size_t lowest = set & (0 - set);
+          size_t rest = set ^ lowest;
+          Value total(0);
+          for (size_t block = rest;; block = (block - 1) & rest) {
+            Value term = weight[block | lowest];
+            term *= partial[rest ^ block];
+            total += term;
+            if (block == 0) {
+              break;
+            }
+          }
+          partial[set] = total;
+          if (index + 1 < last) {
+            size_t ripple = set + lowest;
+            set = (((ripple ^ set) >> 2) / lowest) | ripple;
+          }
+        }
+      }
+      barrier.wait();
+    }
+  });
+  return partial[subsets - 1];
+}
+
+// Picks the engine like sum_multiply_fast, but with the DP's memory counted
+// for Value and the threads. Throws std::bad_alloc if neither engine fits.
+template <typename Value>
+Value parallel_sum_multiply(const int* input, int size_mas, int* const* mas, size_t threads) {
+  if (size_mas > max_size(input, size_mas)) {
+    return Value(0);
+  }
+  double ryser = ryser_cost(input, size_mas);
+  double partitions = parallel_partitions_cost<Value>(input, size_mas);
+  if (ryser >= infinite_cost && partitions >= infinite_cost) {
+    throw std::bad_alloc();
+  }
+  if (ryser < partitions) {
+    return parallel_ryser<Value>(input, size_mas, mas, threads);
+  }
+  return parallel_partitions<Value>(input, size_mas, mas, threads);
+}
@@ -0,0 +1,204 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+
+// Sum of mas[0][i_0] * ... * mas[k - 1][i_{k - 1}] over pairwise distinct
+// indices with i_j < input[j], i.e. the permanent of the k x n matrix whose
+// row j is mas[j] padded with zeros, n = max input[j]. Both engines below
+// work in uint64_t, which wraps modulo 2^64: the intermediate terms do not
+// fit, but the answer does fit in long long, so casting the wrapped sum
+// back gives it exactly.
+
+int max_size(const int* input, int size_mas) {
+  int columns = 0;
+  for (int i = 0; i < size_mas; i++) {
+    if (input[i] > columns) {
+      columns = input[i];
+    }
+  }
+  return columns;
+}
+
+uint64_t entry(const int* input, int* const* mas, int row, int column) {
+  return column < input[row] ? (uint64_t) (int64_t) mas[row][column] : 0;
+}
+
+// Ryser's formula for k <= n: with P(X) the product over rows of the row
+// sums restricted to the columns in X,
+//   sum = sum over |X| <= k of (-1)^(k - |X|) * C(n - |X|, k - |X|) * P(X).
+// The subsets are visited in Gray code order, so every step adds or removes
+// one column from k row sums: O(2^n * k) time, O(n + k) memory, n < 64.
+// Like the engine below, it stores the sum in sum and returns false only if
+// memory runs out.
+bool sum_multiply_ryser(const int* input, int size_mas, int* const* mas, uint64_t& sum) {
+  sum = 0;
+  int columns = max_size(input, size_mas);
+  if (size_mas > columns) {
+    return true;
+  }
+  // coefficient[s] = (-1)^(k - s) * C(n - s, k - s), from one row of
+  // Pascal's triangle updated in place, so there is no division to wrap.
+  uint64_t* binomial = (uint64_t*) calloc((size_t) size_mas + 1, sizeof(uint64_t));
+  uint64_t* coefficient = (uint64_t*) calloc((size_t) size_mas + 1, sizeof(uint64_t));
+  uint64_t* row_sum = (uint64_t*) calloc((size_t) size_mas, sizeof(uint64_t));
+  if (binomial == nullptr || coefficient == nullptr || row_sum == nullptr) {
+    free(binomial);
+    free(coefficient);
+    free(row_sum);
+    return false;
+  }
+  binomial[0] = 1;
+  for (int m = 0; m <= columns; m++) {
+    if (m > 0) {
+      for (int j = size_mas; j > 0; j--) {
+        binomial[j] += binomial[j - 1];
+      }
+    }
+    int lower = size_mas - columns + m;
+    if (lower >= 0) {
+      coefficient[columns - m] = (lower % 2 == 0) ? binomial[lower] : 0 - binomial[lower];
+    }
+  }
+
+  int subset_size = 0;
+  uint64_t subset_count = (uint64_t) 1 << columns;
+  for (uint64_t step = 1; step < subset_count; step++) {
+    int column = __builtin_ctzll(step);
+    bool added = (((step ^ (step >> 1)) >> column) & 1) != 0;
+    subset_size += added ? 1 : -1;
+    for (int i = 0; i < size_mas; i++) {
+      uint64_t value = entry(input, mas, i, column);
+      row_sum[i] += added ? value : 0 - value;
+    }
+    if (subset_size <= size_mas) {
+      uint64_t product = coefficient[subset_size];
+      for (int i = 0; i < size_mas && product != 0; i++) {
+        product *= row_sum[i];
+      }
+      sum += product;
+    }
+  }
+  free(binomial);
+  free(coefficient);
+  free(row_sum);
+  return true;
+}
+
+// Inclusion-exclusion over set partitions of the rows: a tuple with
+// repeated indices is counted once per partition into blocks of equal
+// indices, and the Moebius function of the partition lattice weighs a block
+// B by (-1)^(|B| - 1) * (|B| - 1)!. With g(B) the sum over columns of the
+// product of the rows in B,
+//   f(S) = sum over B in S containing the lowest row of S of
+//          (-1)^(|B| - 1) * (|B| - 1)! * g(B) * f(S \ B)
+// and the answer is f(all rows): O(3^k + 2^k * n) time, O(2^k) memory, so
+// it suits few long rows.
+bool sum_multiply_partitions(const int* input, int size_mas, int* const* mas, uint64_t& sum) {
+  int columns = max_size(input, size_mas);
+  size_t subsets = (size_t) 1 << size_mas;
+  uint64_t* weight = (uint64_t*) calloc(subsets, sizeof(uint64_t));
+  uint64_t* product = (uint64_t*) calloc(subsets, sizeof(uint64_t));
+  uint64_t* factorial = (uint64_t*) calloc((size_t) size_mas, sizeof(uint64_t));
+  if (weight == nullptr || product == nullptr || factorial == nullptr) {
+    free(weight);
+    free(product);
+    free(factorial);
+    return false;
+  }
+  // Products of one column over all sets of rows, doubled one row at a
+  // time: the sets containing row i are the sets below it times its entry.
+  product[0] = 1;
+  for (int column = 0; column < columns; column++) {
+    for (int i = 0; i < size_mas; i++) {
+      size_t half = (size_t) 1 << i;
+      uint64_t value = entry(input, mas, i, column);
+      for (size_t set = 0; set < half; set++) {
+        product[half + set] = product[set] * value;
+      }
+    }
+    for (size_t set = 1; set < subsets; set++) {
+      weight[set] += product[set];
+    }
+  }
+  factorial[0] = 1;
+  for (int i = 1; i < size_mas; i++) {
+    factorial[i] = factorial[i - 1] * (uint64_t) i;
+  }
+  for (size_t set = 1; set < subsets; set++) {
+    int size = __builtin_popcountll(set);
+    uint64_t scale = factorial[size - 1];
+    weight[set] *= (size % 2 == 1) ? scale : 0 - scale;
+  }
+
+  // The products are done with, so their array keeps f.
+  uint64_t* partial = product;
+  partial[0] = 1;
+  for (size_t set = 1; set < subsets; set++) {
+    size_t lowest = set & (0 - set);
+    size_t rest = set ^ lowest;
+    uint64_t total = 0;
+    for (size_t block = rest;; block = (block - 1) & rest) {
+      total += weight[block | lowest] * partial[rest ^ block];
+      if (block == 0) {
+        break;
+      }
+    }
+    partial[set] = total;
+  }
+  sum = partial[subsets - 1];
+  free(weight);
+  free(product);
+  free(factorial);
+  return true;
+}
+
+// The partition DP keeps two arrays of 2^k words. It is not used past this
+// many bytes, which leaves room for the rest under the task's 64 MB.
+const size_t partitions_memory_budget = (size_t) 32 << 20;
+
+const double infinite_cost = 1e300;
+
+// Rough operation counts of the two engines; an engine that cannot run on
+// the input, or not within the memory budget, costs infinity.
+double ryser_cost(const int* input, int size_mas) {
+  int columns = max_size(input, size_mas);
+  if (columns >= 63) {
+    return infinite_cost;
+  }
+  return (double) ((uint64_t) 1 << columns) * 2 * size_mas;
+}
+
+double partitions_cost(const int* input, int size_mas) {
+  if (size_mas >= 40 || ((size_t) 2 << size_mas) * sizeof(uint64_t) > partitions_memory_budget) {
+    return infinite_cost;
+  }
+  double cost = (double) ((uint64_t) 1 << size_mas) * max_size(input, size_mas);
+  double power = 1;
+  for (int i = 0; i < size_mas; i++) {
+    power *= 3;
+  }
+  return cost + power;
+}
+
+// Whether one of the engines can take the input: Ryser needs n < 63, the
+// partition DP k <= 21 for its memory budget.
+bool sum_multiply_fits(const int* input, int size_mas) {
+  return size_mas > max_size(input, size_mas) || ryser_cost(input, size_mas) < infinite_cost
+         || partitions_cost(input, size_mas) < infinite_cost;
+}
+
+// Stores the sum in sum with the cheaper engine. Returns false if neither
+// fits the input or memory runs out.
+bool sum_multiply_fast(const int* input, int size_mas, int* const* mas, uint64_t& sum) {
+  sum = 0;
+  if (size_mas > max_size(input, size_mas)) {
+    return true;
+  }
+  if (!sum_multiply_fits(input, size_mas)) {
+    return false;
+  }
+  if (ryser_cost(input, size_mas) < partitions_cost(input, size_mas)) {
+    return sum_multiply_ryser(input, size_mas, mas, sum);
+  }
+  return sum_multiply_partitions(input, size_mas, mas, sum);
+}
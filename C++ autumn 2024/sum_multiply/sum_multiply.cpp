@@ -1,4 +1,10 @@
+ #include <cassert>
  #include <iostream>
+ #include <cstring>
+
+ #include "../matrix/matrix.h"
+ #include "parallel_permanent.h"
+ #include "permanent.h"
 
  long long sum = 0;
 
@@ -28,36 +34,111 @@
    }
  }
 
+ const size_t residue_modulus = 1000000007;
+
+ // A BigInteger in the partition DP holds up to size_mas ints of 31 bits
+ // multiplied, in base 10^9 digits of int64_t, a few more for the sums.
+ template <>
+ size_t value_bytes<BigInteger>(int size_mas) {
+   size_t digits = (size_t) size_mas * 31 / 29 + 2;
+   return sizeof(BigInteger) + digits * sizeof(int64_t);
+ }
+
+ // ./a.out [options] n_1 ... n_k solves the task with the engine of
+ // permanent.h. Options:
+ //   --brute                 the enumeration above instead
+ //   --threads=N             the engine of parallel_permanent.h on N threads,
+ //                           all cores if N is 0 or not given
+ //   --value=int64|big|mod   what it sums in: long long as the task says,
+ //                           BigInteger for answers that do not fit, or
+ //                           Residue<residue_modulus> for the answer modulo
+ //                           it; anything but int64 runs in parallel
  int main(int argc, char* argv[]) {
-   if (argc == 1) {
+   bool brute = false;
+   bool parallel = false;
+   size_t threads = 0;
+   const char* value = "int64";
+   int first = 1;
+   for (; first < argc && strncmp(argv[first], "--", 2) == 0; first++) {
+     if (strcmp(argv[first], "--brute") == 0) {
+       brute = true;
+     } else if (strncmp(argv[first], "--threads=", 10) == 0) {
+       parallel = true;
+       threads = strtoul(argv[first] + 10, nullptr, 10);
+     } else if (strncmp(argv[first], "--value=", 8) == 0) {
+       value = argv[first] + 8;
+       parallel = parallel || strcmp(value, "int64") != 0;
+     } else {
+       std::cout << "error" << std::endl;
+       return 1;
+     }
+   }
+   if (argc == first) {
      std::cout << "error" << std::endl;
      return 1;
    }
-   int size_mas = argc - 1;
+   if (threads == 0) {
+     threads = std::thread::hardware_concurrency();
+     threads = threads > 0 ? threads : 1;
+   }
+   int size_mas = argc - first;
    int* input = (int*) calloc(size_mas, sizeof(int));
-   for (int i = 1; i < argc; i++) {
-     input[i - 1] = atoi(argv[i]);
+   for (int i = 0; i < size_mas; i++) {
+     input[i] = atoi(argv[first + i]);
+   }
+
+   if (!brute && !sum_multiply_fits(input, size_mas)) {
+     std::cout << "error" << std::endl;
+     free(input);
+     return 1;
    }
 
    int** mas = (int**) calloc(size_mas, sizeof(int*));
-   for (int i = 1; i < argc; i++) {
-     mas[i - 1] = (int*) calloc(input[i - 1], sizeof(int));
+   for (int i = 0; i < size_mas; i++) {
+     mas[i] = (int*) calloc(input[i], sizeof(int));
    }
 
-   for (int i = 1; i < argc; i++) {
-     for (int j = 0; j < input[i - 1]; j++) {
-       std::cin >> mas[i - 1][j];
+   for (int i = 0; i < size_mas; i++) {
+     for (int j = 0; j < input[i]; j++) {
+       std::cin >> mas[i][j];
      }
    }
 
-   int* current = (int*) calloc(size_mas, sizeof(int));
-   int current_size = 0;
-   sum_multiply(input, size_mas, mas, current, current_size);
-   std::cout << sum << std::endl;
+   if (brute) {
+     int* current = (int*) calloc(size_mas, sizeof(int));
+     int current_size = 0;
+     sum_multiply(input, size_mas, mas, current, current_size);
+     free(current);
+     std::cout << sum << std::endl;
+   } else if (!parallel) {
+     uint64_t result = 0;
+     if (sum_multiply_fast(input, size_mas, mas, result)) {
+       sum = (long long) result;
+       std::cout << sum << std::endl;
+     } else {
+       std::cout << "error" << std::endl;
+     }
+   } else {
+     // The parallel engines allocate with std::vector, so running out of
+     // memory, or no engine fitting the budget, ends in std::bad_alloc.
+     try {
+       if (strcmp(value, "big") == 0) {
+         std::cout << parallel_sum_multiply<BigInteger>(input, size_mas, mas, threads) << std::endl;
+       } else if (strcmp(value, "mod") == 0) {
+         std::cout << parallel_sum_multiply<Residue<residue_modulus>>(input, size_mas, mas, threads) << std::endl;
+       } else if (strcmp(value, "int64") == 0) {
+         sum = (long long) parallel_sum_multiply<uint64_t>(input, size_mas, mas, threads);
+         std::cout << sum << std::endl;
+       } else {
+         std::cout << "error" << std::endl;
+       }
+     } catch (const std::bad_alloc&) {
+       std::cout << "error" << std::endl;
+     }
+   }
    free(input);
    for (int i = 0; i < size_mas; i++) {
      free(mas[i]);
    }
    free(mas);
-   free(current);
  }